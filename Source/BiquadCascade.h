@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.h
+    Runs every section of the EQ in a single pass over the block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+/**
+    Fused replacement for a ProcessorChain of IIR::Filters.
+
+    Each sample is taken through all active second order sections before moving
+    on to the next one, so the block is read and written once instead of once
+    per filter. Sections are transposed direct form II and read their
+    coefficients from the struct-of-arrays CascadeCoefficients published by the
+    CoefficientWorker; switching coefficients is a pointer swap.
+
+    Sections switching in or out (a band becoming unity, a slope change) are
+    crossfaded against their own input over CascadeCoefficients::fadeTimeSeconds,
+    so bands can be dropped from the list without clicks.
+
+    SampleType can be a float, a double or a SIMDRegister of either, in which
+    case every lane is an independent channel sharing the same coefficients.
+*/
+template <typename SampleType>
+class BiquadCascade
+{
+public:
+    using NumericType = typename juce::dsp::SampleTypeHelpers::ElementType<SampleType>::Type;
+
+    BiquadCascade() { reset(); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) noexcept
+    {
+        mixStep = static_cast<NumericType>(1.0 / juce::jmax(1.0, CascadeCoefficients::fadeTimeSeconds * spec.sampleRate));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        z1.fill(SampleType { 0 });
+        z2.fill(SampleType { 0 });
+
+        //the next set of coefficients is applied without fading
+        snapMixes = true;
+    }
+
+    /** The coefficients must stay alive until the next call, which is the case for
+        the read slot of the CoefficientWorker's TripleBuffer.
+    */
+    void setCoefficients(const CascadeCoefficients& newCoefficients) noexcept
+    {
+        //sections switching in or out restart from silence rather than stale state
+        auto changedSlots = newCoefficients.activeSlotMask ^ activeSlotMask;
+        auto enteringSlots = newCoefficients.activeSlotMask & changedSlots;
+
+        for (int slot = 0; slot < CascadeCoefficients::maxSections; ++slot)
+        {
+            if ((changedSlots >> slot) & 1u)
+            {
+                z1[(size_t) slot] = SampleType { 0 };
+                z2[(size_t) slot] = SampleType { 0 };
+
+                //entering sections fade in from their input, leaving ones are gone already
+                auto fullyIn = snapMixes && ((enteringSlots >> slot) & 1u) != 0
+                                         && ((newCoefficients.fadingOutSlotMask >> slot) & 1u) == 0;
+                mix[(size_t) slot] = fullyIn ? NumericType (1) : NumericType (0);
+            }
+            else if (snapMixes)
+            {
+                mix[(size_t) slot] = ((newCoefficients.fadingOutSlotMask >> slot) & 1u) != 0 ? NumericType (0) : NumericType (1);
+            }
+        }
+
+        snapMixes = false;
+        activeSlotMask = newCoefficients.activeSlotMask;
+        coefficients = &newCoefficients;
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        static_assert(std::is_same<typename ProcessContext::SampleType, SampleType>::value,
+                      "The sample type of the context must match the cascade");
+
+        auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+
+        jassert(inputBlock.getNumChannels() == 1 && outputBlock.getNumChannels() == 1);
+        jassert(inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom(inputBlock);
+
+        if (context.isBypassed || coefficients == nullptr)
+            return;
+
+        processSamples(outputBlock.getChannelPointer(0), outputBlock.getNumSamples());
+    }
+
+    void processSamples(SampleType* samples, size_t numSamples) noexcept
+    {
+        auto& c = *coefficients;
+
+        //gather the sections that still contribute, so the inner loop runs over contiguous memory
+        std::array<NumericType, CascadeCoefficients::maxSections> b0, b1, b2, a1, a2, m, dm;
+        std::array<SampleType, CascadeCoefficients::maxSections> s1, s2;
+        std::array<int, CascadeCoefficients::maxSections> slots;
+        size_t numSections = 0;
+        bool ramping = false;
+
+        for (size_t k = 0; k < (size_t) c.numSections; ++k)
+        {
+            auto slot = c.slots[k];
+            auto target = ((c.fadingOutSlotMask >> slot) & 1u) != 0 ? NumericType (0) : NumericType (1);
+            auto currentMix = mix[(size_t) slot];
+
+            //faded out sections cost nothing until the worker drops them from the list
+            if (target == NumericType (0) && currentMix == NumericType (0))
+                continue;
+
+            b0[numSections] = static_cast<NumericType>(c.b0[k]);
+            b1[numSections] = static_cast<NumericType>(c.b1[k]);
+            b2[numSections] = static_cast<NumericType>(c.b2[k]);
+            a1[numSections] = static_cast<NumericType>(c.a1[k]);
+            a2[numSections] = static_cast<NumericType>(c.a2[k]);
+            s1[numSections] = z1[(size_t) slot];
+            s2[numSections] = z2[(size_t) slot];
+            m[numSections] = currentMix;
+            dm[numSections] = currentMix < target ? mixStep : (currentMix > target ? -mixStep : NumericType (0));
+            slots[numSections] = slot;
+
+            ramping = ramping || currentMix != target;
+            ++numSections;
+        }
+
+        if (numSections == 0)
+            return;
+
+        if (! ramping)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (size_t k = 0; k < numSections; ++k)
+                {
+                    auto y = x * b0[k] + s1[k];
+                    s1[k] = x * b1[k] - y * a1[k] + s2[k];
+                    s2[k] = x * b2[k] - y * a2[k];
+                    x = y;
+                }
+
+                samples[i] = x;
+            }
+        }
+        else
+        {
+            //blend each section's output with its input while a fade is running
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (size_t k = 0; k < numSections; ++k)
+                {
+                    auto y = x * b0[k] + s1[k];
+                    s1[k] = x * b1[k] - y * a1[k] + s2[k];
+                    s2[k] = x * b2[k] - y * a2[k];
+
+                    m[k] = juce::jlimit(NumericType (0), NumericType (1), m[k] + dm[k]);
+                    x = x + (y - x) * m[k];
+                }
+
+                samples[i] = x;
+            }
+        }
+
+        for (size_t k = 0; k < numSections; ++k)
+        {
+            auto slot = (size_t) slots[k];
+            auto fadedOut = m[k] == NumericType (0);
+
+            z1[slot] = fadedOut ? SampleType { 0 } : s1[k];
+            z2[slot] = fadedOut ? SampleType { 0 } : s2[k];
+            mix[slot] = m[k];
+        }
+    }
+
+    //largest magnitude held in any section's state, across all lanes
+    NumericType getStateMagnitude() const noexcept
+    {
+        NumericType peak (0);
+
+        for (size_t slot = 0; slot < z1.size(); ++slot)
+            peak = juce::jmax(peak, getMagnitude(z1[slot]), getMagnitude(z2[slot]));
+
+        return peak;
+    }
+
+private:
+    static NumericType getMagnitude(const SampleType& value) noexcept
+    {
+        if constexpr (std::is_floating_point<SampleType>::value)
+        {
+            return std::abs(value);
+        }
+        else
+        {
+            NumericType peak (0);
+
+            for (size_t lane = 0; lane < SampleType::size(); ++lane)
+                peak = juce::jmax(peak, std::abs(value.get(lane)));
+
+            return peak;
+        }
+    }
+
+    const CascadeCoefficients* coefficients = nullptr;
+    juce::uint32 activeSlotMask{ 0 };
+
+    //per slot crossfade position between the section's input (0) and output (1)
+    std::array<NumericType, CascadeCoefficients::maxSections> mix{};
+    NumericType mixStep{ 1 };
+    bool snapMixes{ true };
+
+    //state per fixed slot, so it survives sections in front of it switching on or off
+    std::array<SampleType, CascadeCoefficients::maxSections> z1, z2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BiquadCascade)
+};
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "ChannelWorkerPool.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+//the workers are started with Thread::RealtimeOptions::withPeriodMs, which first shipped in JUCE 7.0.6
+static_assert(JUCE_MAJOR_VERSION > 7 || (JUCE_MAJOR_VERSION == 7 && (JUCE_MINOR_VERSION > 0 || JUCE_BUILDNUMBER >= 6)),
+              "SimpleEq needs JUCE 7.0.6 or later");
+
+//tells the core this is a spin wait, so it does not hog the pipeline a sibling hyperthread could use
+static inline void spinPause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && ! JUCE_MSVC
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    release();
+}
+
+void ChannelWorkerPool::prepare(int numWorkerThreads, int maxNumTasks, double blockPeriodSeconds)
+{
+    release();
+
+    maxTasks = juce::jmax(1, maxNumTasks);
+    taskStates.reset(new std::atomic<juce::uint64>[(size_t) maxTasks]);
+
+    for (int task = 0; task < maxTasks; ++task)
+        taskStates[(size_t) task].store(taskTaken);
+
+    auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    periodTicks = (juce::int64) (blockPeriodSeconds * ticksPerSecond);
+
+    //start spinning a couple of milliseconds early, sleeping is only that precise
+    spinLeadTicks = (juce::int64) (0.002 * ticksPerSecond);
+    spinGraceTicks = (juce::int64) (spinGraceSeconds * ticksPerSecond);
+    stallTicks = (juce::int64) (stallSeconds * ticksPerSecond);
+
+    for (int i = 0; i < numWorkerThreads; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this, i + 1));
+        worker->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPeriodMs(blockPeriodSeconds * 1000.0));
+    }
+}
+
+void ChannelWorkerPool::release()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto* worker : workers)
+    {
+        worker->notify();
+        worker->stopThread(1000);
+    }
+
+    workers.clear();
+}
+
+void ChannelWorkerPool::run(Job& job, int tasks) noexcept
+{
+    jassert(tasks > 0 && tasks <= maxTasks);
+    tasks = juce::jmin(tasks, maxTasks);
+
+    //nobody can claim anything while the job is swapped, the previous one has finished completely
+    ++generation;
+    nextBatch.store(((juce::uint64) generation << 32) | closed);
+
+    currentJob.store(&job);
+    numTasks.store(tasks);
+    batchSize.store((tasks + (getNumThreads() + 1) * batchesPerThread - 1) / ((getNumThreads() + 1) * batchesPerThread));
+    completedTasks.store(0);
+
+    for (int task = 0; task < tasks; ++task)
+        taskStates[(size_t) task].store(((juce::uint64) generation << 2) | taskPending);
+
+    nextBatch.store((juce::uint64) generation << 32);
+    lastRunTicks.store(juce::Time::getHighResolutionTicks());
+
+    runBatches(0);
+
+    //a worker that was preempted or woke up late may have claimed a batch it has not got to, its tasks are run here
+    for (int task = 0; task < tasks; ++task)
+        runTask(job, generation, task, 0);
+
+    //only tasks already running on a worker are left. They work on their channels in place, so they
+    //cannot be taken back; after a short spin the audio thread yields in case their worker was preempted
+    auto stallDeadline = juce::Time::getHighResolutionTicks() + stallTicks;
+
+    while (completedTasks.load() < tasks)
+    {
+        if (juce::Time::getHighResolutionTicks() < stallDeadline)
+            spinPause();
+        else
+            juce::Thread::yield();
+    }
+
+    //batches nobody claimed are all taken already
+    nextBatch.store(((juce::uint64) generation << 32) | closed);
+}
+
+bool ChannelWorkerPool::runBatches(int thread) noexcept
+{
+    bool ranAny = false;
+
+    for (;;)
+    {
+        auto claim = nextBatch.load();
+        auto batch = claim & closed;
+
+        if (batch == closed)
+            return ranAny;
+
+        //read before the claim; if the job changed in the meantime the claim below fails
+        auto* job = currentJob.load();
+        auto tasks = numTasks.load();
+        auto size = batchSize.load();
+
+        if (batch * (juce::uint64) size >= (juce::uint64) tasks)
+            return ranAny;
+
+        if (! nextBatch.compare_exchange_weak(claim, claim + 1))
+            continue;
+
+        auto firstTask = (int) batch * size;
+        auto endTask = juce::jmin(tasks, firstTask + size);
+
+        for (auto task = firstTask; task < endTask; ++task)
+            ranAny = runTask(*job, (juce::uint32) (claim >> 32), task, thread) || ranAny;
+    }
+}
+
+bool ChannelWorkerPool::runTask(Job& job, juce::uint32 jobGeneration, int task, int thread) noexcept
+{
+    //fails if the audio thread took the task back, or if the job it belonged to is over
+    auto pending = ((juce::uint64) jobGeneration << 2) | taskPending;
+
+    if (! taskStates[(size_t) task].compare_exchange_strong(pending, ((juce::uint64) jobGeneration << 2) | taskTaken))
+        return false;
+
+    job.run(task, thread);
+    completedTasks.fetch_add(1);
+    return true;
+}
+
+void ChannelWorkerPool::workerLoop(Worker& worker)
+{
+    while (! worker.threadShouldExit())
+    {
+        if (runBatches(worker.index))
+            continue;
+
+        auto now = juce::Time::getHighResolutionTicks();
+        auto nextBlock = lastRunTicks.load() + periodTicks;
+
+        if (now < nextBlock - spinLeadTicks)
+        {
+            //most of the period is spent asleep
+            auto ms = juce::Time::highResolutionTicksToSeconds(nextBlock - spinLeadTicks - now) * 1000.0;
+            worker.wait(juce::jmax(1, (int) ms));
+        }
+        else if (now < nextBlock + spinGraceTicks)
+        {
+            //the block is due, stay awake so it does not pay for a wake up
+            juce::Thread::yield();
+        }
+        else
+        {
+            //the block is late, or the stream has stopped; it starts on the audio thread alone
+            worker.wait(idleWaitMs);
+        }
+    }
+}
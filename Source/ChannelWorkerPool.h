@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.h
+    Persistent threads that share the channels of a wide bus with the audio
+    thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Runs the tasks of a job on the calling thread and on every worker that is
+    awake, and returns once all of them have finished.
+
+    The audio thread never wakes anyone up, so it neither locks nor waits for a
+    thread to be scheduled: it claims batches of tasks itself like any worker,
+    then runs every task a worker has claimed but not started yet, and only
+    waits for the few tasks that are already running. To be awake when a block
+    arrives, the workers sleep until shortly before the next callback is due and
+    spin briefly around it, parking again if it does not come.
+
+    Batches are claimed from a single atomic word holding the job's generation
+    and the next batch index. Each task then has its own word, tagged with the
+    generation, that whoever runs it has to take first, so a task runs exactly
+    once and a worker still holding on to a previous job can never take a task
+    of the current one.
+*/
+class ChannelWorkerPool
+{
+public:
+    struct Job
+    {
+        virtual ~Job() = default;
+
+        //task is below the numTasks given to run(), thread is 0 for the caller and 1..getNumThreads() for the workers
+        virtual void run(int task, int thread) noexcept = 0;
+    };
+
+    ChannelWorkerPool() = default;
+    ~ChannelWorkerPool();
+
+    //not real-time safe, call from prepareToPlay. 0 threads stops the pool, run() takes at most maxNumTasks
+    void prepare(int numWorkerThreads, int maxNumTasks, double blockPeriodSeconds);
+    void release();
+
+    int getNumThreads() const noexcept  { return workers.size(); }
+
+    //audio thread, no locks or allocations
+    void run(Job& job, int numTasks) noexcept;
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(ChannelWorkerPool& poolToJoin, int threadIndex)
+            : juce::Thread("SimpleEq channel worker " + juce::String(threadIndex)), pool(poolToJoin), index(threadIndex) {}
+
+        void run() override  { pool.workerLoop(*this); }
+
+        ChannelWorkerPool& pool;
+        const int index;
+    };
+
+    bool runBatches(int thread) noexcept;
+    bool runTask(Job& job, juce::uint32 jobGeneration, int task, int thread) noexcept;
+    void workerLoop(Worker& worker);
+
+    static constexpr juce::uint64 closed = 0xffffffffu;
+
+    //a task's word holds the generation it was set up for, shifted past these
+    static constexpr juce::uint64 taskPending = 0, taskTaken = 1;
+
+    //generation in the high half, next batch (or closed while a job is being set up) in the low half
+    std::atomic<juce::uint64> nextBatch{ closed };
+    std::atomic<Job*> currentJob{ nullptr };
+    std::atomic<int> numTasks{ 0 }, batchSize{ 1 }, completedTasks{ 0 };
+    juce::uint32 generation = 0;
+
+    std::unique_ptr<std::atomic<juce::uint64>[]> taskStates;
+    int maxTasks = 0;
+
+    std::atomic<juce::int64> lastRunTicks{ 0 };
+    juce::int64 periodTicks = 0, spinLeadTicks = 0, spinGraceTicks = 0, stallTicks = 0;
+
+    juce::OwnedArray<Worker> workers;
+
+    //a few batches per thread, so a worker that wakes late still finds something to take
+    static constexpr int batchesPerThread = 2;
+
+    //workers stay awake this long past the time a block was due, then park until the next one
+    static constexpr double spinGraceSeconds = 0.0001;
+
+    //the audio thread spins this long on tasks still running on a worker, then yields to let a preempted one finish
+    static constexpr double stallSeconds = 0.00005;
+
+    //once no block has come for a while the workers only look for work this often
+    static constexpr int idleWaitMs = 2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelWorkerPool)
+};
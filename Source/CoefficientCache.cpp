@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientCache.h"
+
+//quantisation steps, matching the intervals of the parameter ranges
+static constexpr float frequencyStep = 1.f;
+static constexpr float qualityStep = 0.05f;
+static constexpr float gainStep = 0.5f;
+static constexpr float minGainInDecibels = -24.f;
+
+static constexpr int sampleRateShift = 36;
+
+static BiquadCoefficients toBiquad(const juce::dsp::IIR::Coefficients<double>& coefficients)
+{
+    jassert(coefficients.getFilterOrder() == 2);
+
+    auto* raw = coefficients.getRawCoefficients();
+    return { raw[0], raw[1], raw[2], raw[3], raw[4] };
+}
+
+//==============================================================================
+juce::uint64 CoefficientCache::getSampleRateBits(double sampleRate) noexcept
+{
+    return (juce::uint64) juce::roundToInt(sampleRate) & 0xfffff;
+}
+
+juce::uint64 CoefficientCache::makeKey(Kind kind, double sampleRate, float freq, int order, float quality, float gainInDecibels) noexcept
+{
+    auto frequencyBits = (juce::uint64) juce::roundToInt(freq / frequencyStep) & 0x7fff;
+    auto orderBits = (juce::uint64) order & 0xf;
+    auto qualityBits = (juce::uint64) juce::roundToInt(quality / qualityStep) & 0xff;
+    auto gainBits = (juce::uint64) juce::roundToInt((gainInDecibels - minGainInDecibels) / gainStep) & 0x7f;
+
+    return (getSampleRateBits(sampleRate) << sampleRateShift)
+         | ((juce::uint64) kind << 34)
+         | (gainBits << 27)
+         | (qualityBits << 19)
+         | (orderBits << 15)
+         | frequencyBits;
+}
+
+void CoefficientCache::retainSampleRate(double sampleRate)
+{
+    const juce::ScopedLock sl(lock);
+    ++sampleRateUsers[getSampleRateBits(sampleRate)];
+}
+
+void CoefficientCache::releaseSampleRate(double sampleRate)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto rateBits = getSampleRateBits(sampleRate);
+    auto user = sampleRateUsers.find(rateBits);
+
+    if (user == sampleRateUsers.end() || --user->second > 0)
+        return;
+
+    sampleRateUsers.erase(user);
+
+    //nobody runs at this rate any more, so its designs are stale
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if ((it->first >> sampleRateShift) == rateBits)
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool CoefficientCache::lookup(juce::uint64 key, BandCoefficients& target)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto it = entries.find(key);
+
+    if (it == entries.end())
+    {
+        ++misses;
+        return false;
+    }
+
+    target.sections = it->second.sections;
+    target.numSections = it->second.numSections;
+    ++hits;
+    return true;
+}
+
+void CoefficientCache::insert(juce::uint64 key, const BandCoefficients& designed)
+{
+    const juce::ScopedLock sl(lock);
+
+    if (entries.size() >= maxEntries)
+        entries.clear();
+
+    entries[key] = { designed.sections, designed.numSections };
+}
+
+void CoefficientCache::getCutFilter(BandCoefficients& target, bool isHighpass, float freq, int order, double sampleRate)
+{
+    freq = (float) juce::roundToInt(freq / frequencyStep) * frequencyStep;
+
+    auto key = makeKey(isHighpass ? Kind::highpass : Kind::lowpass, sampleRate, freq, order, 0.f, minGainInDecibels);
+
+    if (lookup(key, target))
+        return;
+
+    auto cutCoefficients = isHighpass
+        ? juce::dsp::FilterDesign<double>::designIIRHighpassHighOrderButterworthMethod(freq, sampleRate, order)
+        : juce::dsp::FilterDesign<double>::designIIRLowpassHighOrderButterworthMethod(freq, sampleRate, order);
+
+    target.numSections = juce::jmin(cutCoefficients.size(), (int) target.sections.size());
+
+    for (int i = 0; i < target.numSections; ++i)
+        target.sections[(size_t) i] = toBiquad(*cutCoefficients.getUnchecked(i));
+
+    insert(key, target);
+}
+
+void CoefficientCache::getPeakFilter(BandCoefficients& target, float freq, float quality, float gainInDecibels, double sampleRate)
+{
+    freq = (float) juce::roundToInt(freq / frequencyStep) * frequencyStep;
+    quality = (float) juce::roundToInt(quality / qualityStep) * qualityStep;
+    gainInDecibels = (float) juce::roundToInt(gainInDecibels / gainStep) * gainStep;
+
+    auto key = makeKey(Kind::peak, sampleRate, freq, 2, quality, gainInDecibels);
+
+    if (lookup(key, target))
+        return;
+
+    auto peakCoefficients = juce::dsp::IIR::Coefficients<double>::makePeakFilter(sampleRate, freq, quality, juce::Decibels::decibelsToGain((double) gainInDecibels));
+
+    target.sections[0] = toBiquad(*peakCoefficients);
+    target.numSections = 1;
+
+    insert(key, target);
+}
+
+void CoefficientCache::getBandPassFilter(BandCoefficients& target, float freq, float quality, double sampleRate)
+{
+    freq = (float) juce::roundToInt(freq / frequencyStep) * frequencyStep;
+    quality = (float) juce::roundToInt(quality / qualityStep) * qualityStep;
+
+    auto key = makeKey(Kind::bandpass, sampleRate, freq, 2, quality, minGainInDecibels);
+
+    if (lookup(key, target))
+        return;
+
+    auto bandPassCoefficients = juce::dsp::IIR::Coefficients<double>::makeBandPass(sampleRate, freq, quality);
+
+    target.sections[0] = toBiquad(*bandPassCoefficients);
+    target.numSections = 1;
+
+    insert(key, target);
+}
+
+CoefficientCache::Stats CoefficientCache::getStats() const
+{
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+
+    const juce::ScopedLock sl(lock);
+    stats.numEntries = entries.size();
+
+    //key, entry and the node and bucket overhead of the hash map
+    stats.memoryBytes = entries.size() * (sizeof(juce::uint64) + sizeof(Entry) + 2 * sizeof(void*))
+                      + entries.bucket_count() * sizeof(void*);
+
+    return stats;
+}
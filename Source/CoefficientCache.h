@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.h
+    Process wide table of designed bands, keyed by quantised parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+/**
+    Turns cut and peak designs into a lookup once a setting has been seen.
+
+    The parameter ranges already quantise frequency to 1 Hz, Q to 0.05 and gain to
+    0.5 dB steps, so every reachable setting maps onto an exact key and no
+    interpolation between entries is needed. Entries are designed lazily on a
+    miss. Use it through a juce::SharedResourcePointer so every plugin instance in
+    the process shares the same table; entries for a sample rate are dropped once
+    no instance runs at that rate any more.
+
+    Only ever used from non-realtime threads.
+*/
+class CoefficientCache
+{
+public:
+    struct Stats
+    {
+        juce::uint64 hits = 0, misses = 0;
+        size_t numEntries = 0, memoryBytes = 0;
+
+        double getHitRate() const noexcept
+        {
+            auto lookups = hits + misses;
+            return lookups > 0 ? (double) hits / (double) lookups : 0.0;
+        }
+    };
+
+    CoefficientCache() = default;
+
+    //every instance registers the rate it runs at, so unused rates can be purged
+    void retainSampleRate(double sampleRate);
+    void releaseSampleRate(double sampleRate);
+
+    //fills the sections and numSections of target, leaving its other members alone
+    void getCutFilter(BandCoefficients& target, bool isHighpass, float freq, int order, double sampleRate);
+    void getPeakFilter(BandCoefficients& target, float freq, float quality, float gainInDecibels, double sampleRate);
+    void getBandPassFilter(BandCoefficients& target, float freq, float quality, double sampleRate);
+
+    Stats getStats() const;
+
+private:
+    struct Entry
+    {
+        std::array<BiquadCoefficients, BandCoefficients::maxSections> sections;
+        int numSections = 0;
+    };
+
+    enum class Kind : juce::uint64 { highpass, lowpass, peak, bandpass };
+
+    static juce::uint64 makeKey(Kind kind, double sampleRate, float freq, int order, float quality, float gainInDecibels) noexcept;
+    static juce::uint64 getSampleRateBits(double sampleRate) noexcept;
+
+    bool lookup(juce::uint64 key, BandCoefficients& target);
+    void insert(juce::uint64 key, const BandCoefficients& designed);
+
+    mutable juce::CriticalSection lock;
+    std::unordered_map<juce::uint64, Entry> entries;
+    std::map<juce::uint64, int> sampleRateUsers;
+
+    std::atomic<juce::uint64> hits{ 0 }, misses{ 0 };
+
+    //keeps a pathological automation sweep across every setting from growing without bound
+    static constexpr size_t maxEntries = 1 << 16;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientCache)
+};
@@ -0,0 +1,480 @@
+/*
+  ==============================================================================
+
+    CoefficientWorker.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientWorker.h"
+#include "PluginProcessor.h"
+
+//topology and dynamics are per session choices kept out of presets, and linear phase mode always
+//designs static biquads. A dynamic band takes precedence over its topology
+static bool usesDynamic(int band, const ChainSettings& chainSettings)
+{
+    return band != LowCut && band != HighCut
+        && chainSettings.phaseMode == MinimumPhase
+        && chainSettings.peaks[(size_t) (band - Peak1)].dynamic;
+}
+
+static bool usesStateVariable(int band, const ChainSettings& chainSettings)
+{
+    return band != LowCut && band != HighCut
+        && chainSettings.phaseMode == MinimumPhase
+        && chainSettings.peaks[(size_t) (band - Peak1)].stateVariable
+        && ! usesDynamic(band, chainSettings);
+}
+
+//bands run by one of the stages after the cascade, or not at all
+static bool isOutOfCascade(const BandCoefficients& band)
+{
+    return band.bypassed || band.stateVariable || band.dynamic;
+}
+
+//samples for a section with poles at the roots of z^2 + a1 z + a2 to decay by tailDecibels
+static double getDecaySamples(double a1, double a2)
+{
+    auto discriminant = a1 * a1 - 4.0 * a2;
+    auto radius = discriminant < 0.0 ? std::sqrt(a2)
+                                     : juce::jmax(std::abs(-a1 + std::sqrt(discriminant)), std::abs(-a1 - std::sqrt(discriminant))) * 0.5;
+
+    //a pole on or outside the unit circle never decays, report the longest tail instead of infinity
+    constexpr double maxDecaySamples = 1 << 22;
+
+    if (radius >= 1.0)
+        return maxDecaySamples;
+
+    if (radius <= 0.0)
+        return 2.0;
+
+    return juce::jmin(maxDecaySamples, std::log(juce::Decibels::decibelsToGain(-CascadeCoefficients::tailDecibels)) / std::log(radius));
+}
+
+//appends a section in the state slot it keeps for as long as it stays in the list
+static void addSection(CascadeCoefficients& cascade, int slot, const BiquadCoefficients& biquad, bool fadingOut)
+{
+    auto index = (size_t) cascade.numSections++;
+
+    cascade.b0[index] = biquad.b0;
+    cascade.b1[index] = biquad.b1;
+    cascade.b2[index] = biquad.b2;
+    cascade.a1[index] = biquad.a1;
+    cascade.a2[index] = biquad.a2;
+    cascade.slots[index] = slot;
+    cascade.activeSlotMask |= 1u << slot;
+
+    //sections ring one after another, so their tails add up
+    cascade.tailSamples += getDecaySamples(biquad.a1, biquad.a2);
+
+    if (fadingOut)
+        cascade.fadingOutSlotMask |= 1u << slot;
+}
+
+//whether a band is still set the way a preset designed it, presets are snapped to the parameters so they compare exactly
+static bool hasSameBandSettings(int band, const ChainSettings& current, const ChainSettings& preset)
+{
+    if (band == LowCut)
+        return current.lowCutFreq == preset.lowCutFreq && current.lowCutSlope == preset.lowCutSlope;
+
+    if (band == HighCut)
+        return current.highCutFreq == preset.highCutFreq && current.highCutSlope == preset.highCutSlope;
+
+    auto& peak = current.peaks[(size_t) (band - Peak1)];
+    auto& presetPeak = preset.peaks[(size_t) (band - Peak1)];
+
+    return peak.freq == presetPeak.freq && peak.gainInDecibels == presetPeak.gainInDecibels && peak.quality == presetPeak.quality;
+}
+
+//largest deviation from 0 dB of a band's sections, looked at across the audible range
+static double getMaxDeviationDecibels(const BandCoefficients& band, double sampleRate)
+{
+    constexpr int numPoints = 64;
+    auto highest = juce::jmin(20000.0, 0.49 * sampleRate);
+    double deviation = 0.0;
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        auto freq = 20.0 * std::pow(highest / 20.0, (double) point / (numPoints - 1));
+        auto w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+        std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+        double magnitude = 1.0;
+
+        for (int section = 0; section < band.numSections; ++section)
+        {
+            auto& biquad = band.sections[(size_t) section];
+            magnitude *= std::abs((biquad.b0 + biquad.b1 * z1 + biquad.b2 * z2) / (1.0 + biquad.a1 * z1 + biquad.a2 * z2));
+        }
+
+        deviation = juce::jmax(deviation, std::abs(juce::Decibels::gainToDecibels(magnitude, -200.0)));
+    }
+
+    return deviation;
+}
+
+//==============================================================================
+CoefficientWorker::CoefficientWorker(juce::AudioProcessorValueTreeState& stateToUse, LinearPhaseFilter& linearPhaseFilter)
+    : apvts(stateToUse), linearPhase(linearPhaseFilter)
+{
+    markAllBandsDirty();
+    designThread->addTimeSliceClient(this, idlePollIntervalMs);
+}
+
+CoefficientWorker::~CoefficientWorker()
+{
+    designThread->removeTimeSliceClient(this);
+
+    if (cacheSampleRate > 0.0)
+        coefficientCache->releaseSampleRate(cacheSampleRate);
+}
+
+void CoefficientWorker::markBandDirty(int band) noexcept
+{
+    bandDirty[(size_t) band].store(true);
+    designPending.store(true, std::memory_order_relaxed);
+}
+
+void CoefficientWorker::markAllBandsDirty() noexcept
+{
+    for (auto& dirty : bandDirty)
+        dirty.store(true);
+
+    designPending.store(true, std::memory_order_relaxed);
+}
+
+void CoefficientWorker::prepare(double sampleRate)
+{
+    //let the shared cache forget designs for a rate nobody uses any more
+    if (sampleRate != cacheSampleRate)
+    {
+        coefficientCache->retainSampleRate(sampleRate);
+
+        if (cacheSampleRate > 0.0)
+            coefficientCache->releaseSampleRate(cacheSampleRate);
+
+        cacheSampleRate = sampleRate;
+    }
+
+    currentSampleRate.store(sampleRate);
+    markAllBandsDirty();
+
+    //a new sample rate starts from silence, so bands switch without fading
+    designPendingBands(false);
+    designPendingKernel(true, sampleRate);
+
+    //presets are designed for the new rate before playback starts, so the first switch is already instant
+    designPendingPresets(sampleRate);
+}
+
+void CoefficientWorker::setPresets(const std::vector<ChainSettings>& presetSettings)
+{
+    const juce::ScopedLock sl(designLock);
+
+    presets = presetSettings;
+    presetBands.clear();
+    presetSampleRate = 0.0;
+}
+
+bool CoefficientWorker::loadPreset(int index)
+{
+    const juce::ScopedLock sl(designLock);
+
+    auto sampleRate = currentSampleRate.load();
+
+    if (sampleRate <= 0.0 || presetSampleRate != sampleRate || ! juce::isPositiveAndBelow(index, (int) presetBands.size()))
+        return false;
+
+    //the parameters were just set to this preset, so what they marked dirty is designed here. The flags are
+    //cleared before the parameters are read, so automation arriving from now on marks its band again
+    for (auto& dirty : bandDirty)
+        dirty.store(false);
+
+    auto chainSettings = parameters.load();
+
+    //presets only hold static biquads, bands set to anything else, or already moved away from the
+    //preset by automation, are designed from the parameters
+    for (int band = 0; band < NumChainPositions; ++band)
+    {
+        if (usesStateVariable(band, chainSettings) || usesDynamic(band, chainSettings)
+            || ! hasSameBandSettings(band, chainSettings, presets[(size_t) index]))
+            designBand(band, chainSettings, sampleRate, true);
+        else
+            applyBand(band, presetBands[(size_t) index][(size_t) band], true);
+    }
+
+    packCascade();
+    publish(sampleRate);
+
+    kernelDirty.store(true);
+    return true;
+}
+
+void CoefficientWorker::setDesignOnCallingThread(bool shouldDesignOnCallingThread)
+{
+    //removing waits for a design that is already running on the thread
+    if (shouldDesignOnCallingThread)
+        designThread->removeTimeSliceClient(this);
+    else
+        designThread->addTimeSliceClient(this, idlePollIntervalMs);
+}
+
+void CoefficientWorker::designPending()
+{
+    designPendingBands(true);
+    designPendingKernel(true, currentSampleRate.load());
+}
+
+int CoefficientWorker::useTimeSlice()
+{
+    auto designed = designPendingBands(true);
+    designed = designPendingKernel(false, currentSampleRate.load()) || designed;
+    designed = designPendingPresets(currentSampleRate.load()) || designed;
+
+    //poll quickly while parameters are moving, back off when the session is static
+    return designed || kernelDirty.load() ? activePollIntervalMs : idlePollIntervalMs;
+}
+
+bool CoefficientWorker::designPendingBands(bool allowFades)
+{
+    const juce::ScopedLock sl(designLock);
+
+    auto sampleRate = currentSampleRate.load();
+
+    if (sampleRate <= 0.0)
+        return false;
+
+    std::array<bool, NumChainPositions> changed;
+    bool anyChanged = false;
+
+    for (size_t i = 0; i < changed.size(); ++i)
+    {
+        changed[i] = bandDirty[i].exchange(false);
+        anyChanged = anyChanged || changed[i];
+    }
+
+    //bands that finished fading out are dropped from the cascade
+    auto now = juce::Time::getMillisecondCounter();
+    bool fadesFinished = false;
+
+    for (auto& deadline : fadeOutDeadlines)
+    {
+        if (deadline != 0 && now >= deadline)
+        {
+            deadline = 0;
+            fadesFinished = true;
+        }
+    }
+
+    if (! anyChanged && ! fadesFinished)
+    {
+        updateDesignPending();
+        return false;
+    }
+
+    if (anyChanged)
+    {
+        auto chainSettings = parameters.load();
+
+        for (int band = 0; band < NumChainPositions; ++band)
+            if (changed[(size_t) band])
+                designBand(band, chainSettings, sampleRate, allowFades);
+    }
+
+    //the packed list changes with every redesign and every finished fade, the kernel follows it
+    packCascade();
+    kernelDirty.store(true);
+
+    publish(sampleRate);
+
+    return true;
+}
+
+void CoefficientWorker::publish(double sampleRate)
+{
+    designed.sampleRate = sampleRate;
+
+    //hand a complete set over, the slot being overwritten is never the one the audio thread reads
+    coefficientBuffer.getWriteBuffer() = designed;
+    coefficientBuffer.publish();
+
+    displayBuffer.getWriteBuffer() = designed;
+    displayBuffer.publish();
+
+    updateDesignPending();
+}
+
+void CoefficientWorker::updateDesignPending() noexcept
+{
+    //a band marked dirty while this runs may be cleared too early, it is then picked up
+    //at the start of the next block as before, and the next publish sets the flag right again
+    auto pending = std::any_of(bandDirty.begin(), bandDirty.end(), [](const std::atomic<bool>& dirty) { return dirty.load(); })
+                || std::any_of(fadeOutDeadlines.begin(), fadeOutDeadlines.end(), [](juce::uint32 deadline) { return deadline != 0; });
+
+    designPending.store(pending, std::memory_order_relaxed);
+}
+
+bool CoefficientWorker::designPendingPresets(double sampleRate)
+{
+    const juce::ScopedLock sl(designLock);
+
+    if (sampleRate <= 0.0 || presetSampleRate == sampleRate)
+        return false;
+
+    presetBands.resize(presets.size());
+
+    for (size_t preset = 0; preset < presets.size(); ++preset)
+        for (int band = 0; band < NumChainPositions; ++band)
+            designBandCoefficients(band, presets[preset], sampleRate, presetBands[preset][(size_t) band]);
+
+    presetSampleRate = sampleRate;
+    return true;
+}
+
+bool CoefficientWorker::designPendingKernel(bool force, double sampleRate)
+{
+    const juce::ScopedLock sl(designLock);
+
+    auto now = juce::Time::getMillisecondCounter();
+
+    if (sampleRate <= 0.0 || ! kernelDirty.load() || (! force && now - lastKernelTime < kernelIntervalMs))
+        return false;
+
+    kernelDirty.store(false);
+    lastKernelTime = now;
+
+    //minimum phase never touches the kernel, switching modes marks it dirty again
+    auto chainSettings = parameters.load();
+
+    if (chainSettings.phaseMode != LinearPhase)
+        return false;
+
+    linearPhase.design(designed.cascade, LinearPhaseFilter::getKernelLength(chainSettings.linearPhaseQuality), sampleRate);
+    return true;
+}
+
+void CoefficientWorker::designBand(int band, const ChainSettings& chainSettings, double sampleRate, bool allowFades)
+{
+    BandCoefficients newBand;
+    designBandCoefficients(band, chainSettings, sampleRate, newBand);
+    applyBand(band, newBand, allowFades);
+}
+
+void CoefficientWorker::designBandCoefficients(int band, const ChainSettings& chainSettings, double sampleRate, BandCoefficients& target)
+{
+    target.stateVariable = usesStateVariable(band, chainSettings);
+    target.dynamic = usesDynamic(band, chainSettings);
+
+    if (band == LowCut)
+    {
+        coefficientCache->getCutFilter(target, true, chainSettings.lowCutFreq, 2 * (chainSettings.lowCutSlope + 1), sampleRate);
+    }
+    else if (band == HighCut)
+    {
+        coefficientCache->getCutFilter(target, false, chainSettings.highCutFreq, 2 * (chainSettings.highCutSlope + 1), sampleRate);
+    }
+    else
+    {
+        auto& peak = chainSettings.peaks[(size_t) (band - Peak1)];
+        coefficientCache->getPeakFilter(target, peak.freq, peak.quality, peak.gainInDecibels, sampleRate);
+
+        if (target.dynamic)
+        {
+            //kept inside the gain parameter's range, which is also what the cache quantises for
+            auto fullRangeDecibels = juce::jlimit(-24.f, 24.f, peak.gainInDecibels + peak.rangeInDecibels);
+
+            BandCoefficients designed;
+            coefficientCache->getPeakFilter(designed, peak.freq, peak.quality, fullRangeDecibels, sampleRate);
+            target.rangeSection = designed.sections[0];
+
+            coefficientCache->getBandPassFilter(designed, peak.freq, peak.quality, sampleRate);
+            target.detectorSection = designed.sections[0];
+        }
+    }
+
+    target.bypassed = isEffectivelyUnity(band, chainSettings, target, sampleRate);
+}
+
+void CoefficientWorker::applyBand(int band, const BandCoefficients& newBand, bool allowFades)
+{
+    auto& target = designed.bands[(size_t) band];
+    auto& deadline = fadeOutDeadlines[(size_t) band];
+    auto& dropped = droppedSections[(size_t) band];
+
+    //a band leaving the cascade, for unity or for one of the later stages, fades out before it is dropped
+    auto leaving = isOutOfCascade(newBand);
+
+    //so do the sections a lower slope no longer needs, with the design they were last packed with
+    auto numPacked = packedSections[(size_t) band];
+    dropped.numSections = allowFades && newBand.numSections < numPacked ? numPacked : 0;
+
+    for (int section = newBand.numSections; section < dropped.numSections; ++section)
+        if (section < target.numSections)
+            dropped.sections[(size_t) section] = target.sections[(size_t) section];
+
+    if (dropped.numSections > 0 || (leaving && ! isOutOfCascade(target) && allowFades))
+        deadline = juce::jmax(1u, juce::Time::getMillisecondCounter() + fadeOutHoldMs);
+    else if (! leaving || ! allowFades)
+        deadline = 0;
+
+    auto version = target.version;
+    target = newBand;
+    target.version = version + 1;
+}
+
+bool CoefficientWorker::isEffectivelyUnity(int band, const ChainSettings& chainSettings, const BandCoefficients& designedBand, double sampleRate) const
+{
+    //a cut at the edge of its range still shapes the top or bottom octave, e.g. a 20 kHz
+    //high cut at 44.1 kHz, so only one measured to be flat across the audible range goes
+    if (band == LowCut || band == HighCut)
+        return getMaxDeviationDecibels(designedBand, sampleRate) < unityToleranceDecibels;
+
+    //a peak deviates most at its centre, which a grid of frequencies can miss, so its gain decides.
+    //A dynamic band flat at rest still acts once its detector opens
+    auto& peak = chainSettings.peaks[(size_t) (band - Peak1)];
+    auto dynamicRange = usesDynamic(band, chainSettings) ? peak.rangeInDecibels : 0.f;
+
+    return std::abs(peak.gainInDecibels) < unityToleranceDecibels && std::abs(dynamicRange) < unityToleranceDecibels;
+}
+
+void CoefficientWorker::packCascade()
+{
+    auto& cascade = designed.cascade;
+    cascade.numSections = 0;
+    cascade.activeSlotMask = 0;
+    cascade.fadingOutSlotMask = 0;
+    cascade.tailSamples = 0.0;
+
+    for (int band = 0; band < NumChainPositions; ++band)
+    {
+        auto& bandCoefficients = designed.bands[(size_t) band];
+        auto outOfCascade = isOutOfCascade(bandCoefficients);
+        auto fading = fadeOutDeadlines[(size_t) band] != 0;
+        auto fadingOut = outOfCascade && fading;
+        auto numDropped = fading ? droppedSections[(size_t) band].numSections : 0;
+
+        packedSections[(size_t) band] = 0;
+
+        //unity bands and those of the later stages are left out entirely once they have faded out,
+        //the latter still ring after the cascade so their tail counts
+        if (outOfCascade && ! fadingOut)
+        {
+            if (! bandCoefficients.bypassed)
+                for (int section = 0; section < bandCoefficients.numSections; ++section)
+                    cascade.tailSamples += getDecaySamples(bandCoefficients.sections[(size_t) section].a1,
+                                                           bandCoefficients.sections[(size_t) section].a2);
+
+            continue;
+        }
+
+        auto firstSlot = CascadeCoefficients::getFirstSlot(band);
+
+        for (int section = 0; section < bandCoefficients.numSections; ++section)
+            addSection(cascade, firstSlot + section, bandCoefficients.sections[(size_t) section], fadingOut);
+
+        //sections dropped by a lower slope fade out in their own slots, after the ones that stay
+        for (int section = bandCoefficients.numSections; section < numDropped; ++section)
+            addSection(cascade, firstSlot + section, droppedSections[(size_t) band].sections[(size_t) section], true);
+
+        packedSections[(size_t) band] = juce::jmax(bandCoefficients.numSections, numDropped);
+    }
+}
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    CoefficientWorker.h
+    Designs filter coefficients off the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+#include "CoefficientCache.h"
+#include "TripleBuffer.h"
+#include "LinearPhaseFilter.h"
+#include "EqParameters.h"
+
+/**
+    Watches the per band dirty flags, redesigns only the bands that changed on a
+    background thread and publishes complete CoefficientSets to the audio thread
+    through a TripleBuffer. One design thread is shared by every plugin instance
+    in the process. In linear phase mode it also rebuilds the FIR kernel of the
+    LinearPhaseFilter, at most once every kernelIntervalMs.
+*/
+class CoefficientWorker : private juce::TimeSliceClient
+{
+public:
+    CoefficientWorker(juce::AudioProcessorValueTreeState& apvts, LinearPhaseFilter& linearPhaseFilter);
+    ~CoefficientWorker() override;
+
+    //safe to call from any thread, including the audio thread
+    void markBandDirty(int band) noexcept;
+    void markAllBandsDirty() noexcept;
+
+    //phase mode or kernel length changed, the bands themselves are unaffected
+    void markKernelDirty() noexcept  { kernelDirty.store(true); }
+
+    //designs every band synchronously, call from prepareToPlay
+    void prepare(double sampleRate);
+
+    //message thread: designs every preset for the current sample rate on the design thread
+    void setPresets(const std::vector<ChainSettings>& presetSettings);
+
+    //message thread, call after the parameters have been set to the preset. Publishes the
+    //preset's ready made coefficients, returns false if they are not designed yet
+    bool loadPreset(int index);
+
+    //for offline renders and benchmarks: takes the worker off the shared design thread, so that
+    //nothing is designed until designPending() is called on the thread that wants it
+    void setDesignOnCallingThread(bool shouldDesignOnCallingThread);
+
+    //designs and publishes whatever is pending right away, kernel included
+    void designPending();
+
+    //hit rate and footprint of the cache shared by all instances
+    CoefficientCache::Stats getCacheStats() const  { return coefficientCache->getStats(); }
+
+    //true from a band being marked dirty until its redesign (and any fade it started) has
+    //been published. The audio thread only splits blocks to pick up new sets while it is set
+    bool isDesignPending() const noexcept  { return designPending.load(std::memory_order_relaxed); }
+
+    //audio thread only, returns nullptr when nothing new was published
+    const CoefficientSet* getNewCoefficients() noexcept { return coefficientBuffer.acquireLatest(); }
+
+    //message thread only, the same sets published separately so that the editor never holds up the audio thread
+    const CoefficientSet* getNewDisplayCoefficients() noexcept  { return displayBuffer.acquireLatest(); }
+    const CoefficientSet& getLastDisplayCoefficients() const noexcept  { return displayBuffer.getReadBuffer(); }
+
+private:
+    struct DesignThread : public juce::TimeSliceThread
+    {
+        DesignThread() : juce::TimeSliceThread("SimpleEq coefficient designer") { startThread(); }
+        ~DesignThread() override { stopThread(1000); }
+    };
+
+    int useTimeSlice() override;
+    bool designPendingBands(bool allowFades);
+    bool designPendingKernel(bool force, double sampleRate);
+    bool designPendingPresets(double sampleRate);
+    void designBand(int band, const ChainSettings& chainSettings, double sampleRate, bool allowFades);
+    void designBandCoefficients(int band, const ChainSettings& chainSettings, double sampleRate, BandCoefficients& target);
+    void applyBand(int band, const BandCoefficients& newBand, bool allowFades);
+    void publish(double sampleRate);
+    void updateDesignPending() noexcept;
+    bool isEffectivelyUnity(int band, const ChainSettings& chainSettings, const BandCoefficients& designedBand, double sampleRate) const;
+    void packCascade();
+
+    juce::AudioProcessorValueTreeState& apvts;
+    ChainParameters parameters{ apvts };
+    LinearPhaseFilter& linearPhase;
+
+    std::array<std::atomic<bool>, NumChainPositions> bandDirty;
+    std::atomic<bool> designPending{ false };
+    std::atomic<double> currentSampleRate{ 0.0 };
+
+    std::atomic<bool> kernelDirty{ true };
+    juce::uint32 lastKernelTime = 0;
+
+    juce::CriticalSection designLock;
+    CoefficientSet designed;
+
+    //when a band that just became unity, or the sections a lower slope dropped, can leave the
+    //cascade, 0 if nothing of the band is fading out
+    std::array<juce::uint32, NumChainPositions> fadeOutDeadlines{};
+
+    //the sections of each band fading out after a slope change (from its new numSections on),
+    //and how many sections of each band the last packCascade placed
+    std::array<BandCoefficients, NumChainPositions> droppedSections;
+    std::array<int, NumChainPositions> packedSections{};
+    TripleBuffer<CoefficientSet> coefficientBuffer, displayBuffer;
+
+    std::vector<ChainSettings> presets;
+    std::vector<std::array<BandCoefficients, NumChainPositions>> presetBands;
+    double presetSampleRate = 0.0;
+
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+    double cacheSampleRate = 0.0;
+
+    juce::SharedResourcePointer<DesignThread> designThread;
+
+    static constexpr int activePollIntervalMs = 1;
+    static constexpr int idlePollIntervalMs = 10;
+
+    //bands closer to flat than this everywhere from 20 Hz to 20 kHz are dropped from the cascade
+    static constexpr double unityToleranceDecibels = 0.01;
+
+    //gives the audio thread time to pick up the faded set and finish the ramp
+    static constexpr juce::uint32 fadeOutHoldMs = 50;
+
+    //kernels are expensive to design and crossfade, so automation only rebuilds them this often
+    static constexpr juce::uint32 kernelIntervalMs = 30;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientWorker)
+};
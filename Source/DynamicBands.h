@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    DynamicBands.h
+    Peak bands whose gain follows the level in their own frequency range.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+/**
+    Runs the peaks switched to dynamic after the cascade. The worker designs two
+    peaks per band, one at rest and one at the full range, plus the band pass its
+    detector listens through. Nothing is designed on the audio thread: every
+    segment of segmentSize samples interpolates between the two designs by how
+    far the detected level is above the threshold. Interpolating normalised
+    coefficients of two stable sections stays stable, as the stability triangle
+    is convex.
+
+    The detector works a block at a time on the input before the EQ, or the
+    sidechain. Every channel goes through the band's band pass on its own and the
+    loudest channel sets the level, so content in anti-phase between channels is
+    heard instead of cancelling as it would in a mono sum. Squaring and the max
+    across channels are vector operations; only the band passes and the envelope
+    follower are sample by sample. Bands that are not
+    dynamic have no detector, and with none running the stage costs nothing.
+*/
+template <typename FloatType>
+class DynamicBands
+{
+public:
+    //the detector can be wider than the filtered channels, when a wider sidechain is connected
+    void prepare(const juce::dsp::ProcessSpec& spec, int numDetectorChannelsToUse)
+    {
+        sampleRate = spec.sampleRate;
+        numChannels = (size_t) spec.numChannels;
+        numDetectorChannels = (size_t) numDetectorChannelsToUse;
+        maximumBlockSize = (size_t) spec.maximumBlockSize;
+
+        auto maxSegments = (maximumBlockSize + segmentSize - 1) / segmentSize;
+
+        for (auto& band : bands)
+        {
+            band.z1.assign(numChannels, FloatType (0));
+            band.z2.assign(numChannels, FloatType (0));
+            band.positions.assign(maxSegments, FloatType (0));
+            band.detectorZ1.assign(numDetectorChannels, 0.0);
+            band.detectorZ2.assign(numDetectorChannels, 0.0);
+        }
+
+        for (auto* buffer : { &bandPassed, &bandPower })
+            buffer->assign(maximumBlockSize, FloatType (0));
+
+        for (auto* coefficients : { &b0, &b1, &b2, &a1, &a2, &mixes })
+            coefficients->assign(maxSegments, FloatType (0));
+
+        //entering and leaving bands crossfade over the same time as the cascade's sections
+        mixStep = (double) segmentSize / juce::jmax(1.0, CascadeCoefficients::fadeTimeSeconds * sampleRate);
+        attackMs = releaseMs = -1.f;
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& band : bands)
+        {
+            clearState(band);
+            band.running = band.enabled;
+            band.mix = band.enabled ? 1.0 : 0.0;
+        }
+    }
+
+    //called with the published coefficients, so the switch lines up with the cascade's crossfade.
+    //The designs are copied, a band fading out keeps the last ones it had
+    void setBand(int peak, const BandCoefficients& coefficients) noexcept
+    {
+        auto& band = bands[(size_t) peak];
+        band.enabled = coefficients.dynamic && ! coefficients.bypassed;
+
+        if (! band.enabled)
+            return;
+
+        band.rest = coefficients.sections[0];
+        band.range = coefficients.rangeSection;
+        band.detector = coefficients.detectorSection;
+
+        if (! band.running)
+        {
+            clearState(band);
+            band.mix = 0.0;
+            band.running = true;
+        }
+    }
+
+    //audio thread, once per block from the parameters
+    void setThreshold(int peak, float thresholdInDecibels) noexcept
+    {
+        bands[(size_t) peak].thresholdInDecibels = (double) thresholdInDecibels;
+    }
+
+    void setTiming(float newAttackMs, float newReleaseMs) noexcept
+    {
+        if (newAttackMs == attackMs && newReleaseMs == releaseMs)
+            return;
+
+        attackMs = newAttackMs;
+        releaseMs = newReleaseMs;
+
+        attackCoefficient = 1.0 - std::exp(-1.0 / juce::jmax(1.0, 0.001 * attackMs * sampleRate));
+        releaseCoefficient = 1.0 - std::exp(-1.0 / juce::jmax(1.0, 0.001 * releaseMs * sampleRate));
+    }
+
+    bool isActive() const noexcept
+    {
+        return std::any_of(bands.begin(), bands.end(), [](const Band& band) { return band.running; });
+    }
+
+    FloatType getStateMagnitude() const noexcept
+    {
+        FloatType peak (0);
+
+        for (auto& band : bands)
+            if (band.running)
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    peak = juce::jmax(peak, std::abs(band.z1[channel]), std::abs(band.z2[channel]));
+
+        return peak;
+    }
+
+    //before the cascade, on the unprocessed input or the sidechain
+    void analyse(const juce::dsp::AudioBlock<FloatType>& detectorInput) noexcept
+    {
+        auto numSamples = (int) detectorInput.getNumSamples();
+        auto detectorChannels = juce::jmin(detectorInput.getNumChannels(), numDetectorChannels);
+
+        jassert((size_t) numSamples <= maximumBlockSize);
+        jassert(detectorInput.getNumChannels() <= numDetectorChannels);
+
+        for (auto& band : bands)
+        {
+            if (! band.running)
+                continue;
+
+            //the band's power in each channel, the loudest one at every sample is the level
+            if (detectorChannels == 0)
+                juce::FloatVectorOperations::clear(bandPower.data(), numSamples);
+
+            for (size_t channel = 0; channel < detectorChannels; ++channel)
+            {
+                bandPass(band, channel, detectorInput.getChannelPointer(channel), numSamples);
+
+                if (channel == 0)
+                {
+                    juce::FloatVectorOperations::multiply(bandPower.data(), bandPassed.data(), bandPassed.data(), numSamples);
+                }
+                else
+                {
+                    juce::FloatVectorOperations::multiply(bandPassed.data(), bandPassed.data(), numSamples);
+                    juce::FloatVectorOperations::max(bandPower.data(), bandPower.data(), bandPassed.data(), numSamples);
+                }
+            }
+
+            for (size_t start = 0, segment = 0; start < (size_t) numSamples; start += segmentSize, ++segment)
+            {
+                auto end = juce::jmin((size_t) numSamples, start + segmentSize);
+                auto envelope = band.envelope;
+
+                for (auto i = start; i < end; ++i)
+                {
+                    auto power = (double) bandPower[i];
+                    envelope += (power > envelope ? attackCoefficient : releaseCoefficient) * (power - envelope);
+                }
+
+                band.envelope = envelope;
+
+                auto levelInDecibels = 10.0 * std::log10(envelope + 1.0e-20);
+                band.positions[segment] = (FloatType) juce::jlimit(0.0, 1.0, (levelInDecibels - band.thresholdInDecibels) / fullRangeAboveThreshold);
+            }
+        }
+    }
+
+    //after the cascade, on the same block analyse was given the input of
+    void process(juce::dsp::AudioBlock<FloatType>& block) noexcept
+    {
+        auto numSamples = block.getNumSamples();
+        auto channelsToProcess = juce::jmin(block.getNumChannels(), numChannels);
+        auto numSegments = (numSamples + segmentSize - 1) / segmentSize;
+
+        for (auto& band : bands)
+        {
+            if (! band.running)
+                continue;
+
+            //one interpolated section and one mix per segment, shared by every channel
+            auto targetMix = band.enabled ? 1.0 : 0.0;
+
+            for (size_t segment = 0; segment < numSegments; ++segment)
+            {
+                auto t = band.positions[segment];
+
+                b0[segment] = interpolate(band.rest.b0, band.range.b0, t);
+                b1[segment] = interpolate(band.rest.b1, band.range.b1, t);
+                b2[segment] = interpolate(band.rest.b2, band.range.b2, t);
+                a1[segment] = interpolate(band.rest.a1, band.range.a1, t);
+                a2[segment] = interpolate(band.rest.a2, band.range.a2, t);
+
+                band.mix = band.mix < targetMix ? juce::jmin(targetMix, band.mix + mixStep)
+                                                : juce::jmax(targetMix, band.mix - mixStep);
+                mixes[segment] = (FloatType) band.mix;
+            }
+
+            for (size_t channel = 0; channel < channelsToProcess; ++channel)
+                processChannel(band, channel, block.getChannelPointer(channel), numSamples);
+
+            //a band switched out stops once it has faded away
+            if (! band.enabled && band.mix <= 0.0)
+            {
+                band.running = false;
+                clearState(band);
+            }
+        }
+    }
+
+private:
+    struct Band
+    {
+        BiquadCoefficients rest, range, detector;
+        std::vector<FloatType> z1, z2, positions;
+        std::vector<double> detectorZ1, detectorZ2;
+        double envelope = 0.0;
+        double thresholdInDecibels = -24.0, mix = 0.0;
+        bool enabled = false, running = false;
+    };
+
+    static FloatType interpolate(double rest, double range, FloatType t) noexcept
+    {
+        return (FloatType) rest + t * (FloatType) (range - rest);
+    }
+
+    void clearState(Band& band) noexcept
+    {
+        std::fill(band.z1.begin(), band.z1.end(), FloatType (0));
+        std::fill(band.z2.begin(), band.z2.end(), FloatType (0));
+        std::fill(band.positions.begin(), band.positions.end(), FloatType (0));
+        std::fill(band.detectorZ1.begin(), band.detectorZ1.end(), 0.0);
+        std::fill(band.detectorZ2.begin(), band.detectorZ2.end(), 0.0);
+        band.envelope = 0.0;
+    }
+
+    void bandPass(Band& band, size_t channel, const FloatType* samples, int numSamples) noexcept
+    {
+        auto& c = band.detector;
+        auto z1 = band.detectorZ1[channel], z2 = band.detectorZ2[channel];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x = (double) samples[i];
+            auto y = c.b0 * x + z1;
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            bandPassed[(size_t) i] = (FloatType) y;
+        }
+
+        band.detectorZ1[channel] = z1;
+        band.detectorZ2[channel] = z2;
+    }
+
+    void processChannel(Band& band, size_t channel, FloatType* samples, size_t numSamples) noexcept
+    {
+        auto z1 = band.z1[channel];
+        auto z2 = band.z2[channel];
+
+        for (size_t start = 0, segment = 0; start < numSamples; start += segmentSize, ++segment)
+        {
+            auto end = juce::jmin(numSamples, start + segmentSize);
+            auto sb0 = b0[segment], sb1 = b1[segment], sb2 = b2[segment], sa1 = a1[segment], sa2 = a2[segment];
+            auto mix = mixes[segment];
+
+            for (auto i = start; i < end; ++i)
+            {
+                auto x = samples[i];
+                auto y = sb0 * x + z1;
+                z1 = sb1 * x - sa1 * y + z2;
+                z2 = sb2 * x - sa2 * y;
+                samples[i] = x + mix * (y - x);
+            }
+        }
+
+        band.z1[channel] = z1;
+        band.z2[channel] = z2;
+    }
+
+    std::array<Band, (size_t) numPeakBands> bands;
+    std::vector<FloatType> bandPassed, bandPower;
+    std::vector<FloatType> b0, b1, b2, a1, a2, mixes;
+
+    double sampleRate = 44100.0, mixStep = 1.0;
+    size_t numChannels = 0, numDetectorChannels = 0, maximumBlockSize = 0;
+
+    float attackMs = -1.f, releaseMs = -1.f;
+    double attackCoefficient = 1.0, releaseCoefficient = 1.0;
+
+    //coefficients are interpolated once per segment, about a third of a millisecond at 48 kHz
+    static constexpr size_t segmentSize = 16;
+
+    //the band reaches its full range this far above the threshold
+    static constexpr double fullRangeAboveThreshold = 12.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DynamicBands)
+};
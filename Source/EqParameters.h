@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+
+    EqParameters.h
+    The band model: settings, parameter layout and cached parameter handles,
+    all generated from the number of peak bands.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+#include "LinearPhaseFilter.h"
+
+enum Slope
+{
+	slope_12,
+	slope_24,
+    slope_36,
+	slope_48
+};
+
+struct PeakSettings
+{
+    float freq{ 750.f }, gainInDecibels{ 0.f }, quality{ 1.f };
+
+    //run by StateVariableBands instead of the cascade, factory presets leave it off
+    bool stateVariable{ false };
+
+    //gain moves by up to rangeInDecibels as the band's level rises above the threshold, factory presets leave it off
+    bool dynamic{ false };
+    float thresholdInDecibels{ -24.f }, rangeInDecibels{ -6.f };
+};
+
+struct ChainSettings
+{
+	float lowCutFreq{ 0 }, highCutFreq{ 0 };
+    std::array<PeakSettings, (size_t) numPeakBands> peaks;
+
+    Slope lowCutSlope{ Slope::slope_12 }, highCutSlope{ Slope::slope_12 };
+
+    PhaseMode phaseMode{ MinimumPhase };
+    int linearPhaseQuality{ 1 };
+
+    //shared by every dynamic band, the detectors listen to the sidechain bus when it is switched on and connected
+    float dynamicsAttackMs{ 5.f }, dynamicsReleaseMs{ 100.f };
+    bool sidechain{ false };
+};
+
+/**
+    One std::atomic<float>* per parameter, resolved once from the tree, so
+    reading the settings is a handful of plain atomic loads with no string
+    hashing. The parameter layout is generated from numPeakBands, which keeps
+    the ids ("Peak1 Freq" ...) identical to the hand written layout.
+*/
+struct ChainParameters
+{
+    struct PeakHandles
+    {
+        std::atomic<float>* freq;
+        std::atomic<float>* gain;
+        std::atomic<float>* quality;
+        std::atomic<float>* topology;
+        std::atomic<float>* dynamic;
+        std::atomic<float>* threshold;
+        std::atomic<float>* range;
+    };
+
+    std::atomic<float>* lowCutFreq;
+    std::atomic<float>* highCutFreq;
+    std::array<PeakHandles, (size_t) numPeakBands> peaks;
+    std::atomic<float>* lowCutSlope;
+    std::atomic<float>* highCutSlope;
+    std::atomic<float>* phaseMode;
+    std::atomic<float>* linearPhaseQuality;
+    std::atomic<float>* dynamicsAttack;
+    std::atomic<float>* dynamicsRelease;
+    std::atomic<float>* sidechain;
+
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& apvts)
+        : lowCutFreq(apvts.getRawParameterValue("LowCut Freq")),
+          highCutFreq(apvts.getRawParameterValue("HighCut Freq")),
+          lowCutSlope(apvts.getRawParameterValue("LowCut Slope")),
+          highCutSlope(apvts.getRawParameterValue("HighCut Slope")),
+          phaseMode(apvts.getRawParameterValue("Phase Mode")),
+          linearPhaseQuality(apvts.getRawParameterValue("Linear Phase Quality")),
+          dynamicsAttack(apvts.getRawParameterValue("Dynamics Attack")),
+          dynamicsRelease(apvts.getRawParameterValue("Dynamics Release")),
+          sidechain(apvts.getRawParameterValue("Sidechain"))
+    {
+        for (int peak = 0; peak < numPeakBands; ++peak)
+            peaks[(size_t) peak] = { apvts.getRawParameterValue(getPeakParameterID(peak, "Freq")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Gain")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Quality")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Topology")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Dynamic")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Threshold")),
+                                     apvts.getRawParameterValue(getPeakParameterID(peak, "Range")) };
+    }
+
+    ChainSettings load() const noexcept
+    {
+        ChainSettings settings;
+
+        settings.lowCutFreq = lowCutFreq->load();
+        settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load());
+
+        settings.highCutFreq = highCutFreq->load();
+        settings.highCutSlope = static_cast<Slope>(highCutSlope->load());
+
+        for (size_t peak = 0; peak < peaks.size(); ++peak)
+            settings.peaks[peak] = { peaks[peak].freq->load(), peaks[peak].gain->load(), peaks[peak].quality->load(),
+                                     peaks[peak].topology->load() >= 0.5f,
+                                     peaks[peak].dynamic->load() >= 0.5f, peaks[peak].threshold->load(), peaks[peak].range->load() };
+
+        settings.phaseMode = static_cast<PhaseMode>(phaseMode->load());
+        settings.linearPhaseQuality = static_cast<int>(linearPhaseQuality->load());
+
+        settings.dynamicsAttackMs = dynamicsAttack->load();
+        settings.dynamicsReleaseMs = dynamicsRelease->load();
+        settings.sidechain = sidechain->load() >= 0.5f;
+
+        return settings;
+    }
+
+    static juce::String getPeakParameterID(int peak, const juce::String& suffix)
+    {
+        return "Peak" + juce::String(peak + 1) + " " + suffix;
+    }
+
+    //ChainPositions entry a parameter belongs to, -1 for the ones that are not part of a band
+    static int getBandForParameterID(const juce::String& parameterID)
+    {
+        if (parameterID.startsWith("LowCut"))
+            return LowCut;
+
+        if (parameterID.startsWith("HighCut"))
+            return HighCut;
+
+        if (parameterID.startsWith("Peak"))
+        {
+            //parsed in place, this runs on the audio thread for automation and must not allocate
+            auto peak = (parameterID.getCharPointer() + 4).getIntValue32() - 1;
+
+            if (juce::isPositiveAndBelow(peak, numPeakBands))
+                return Peak1 + peak;
+        }
+
+        return -1;
+    }
+
+    static void addToLayout(juce::AudioProcessorValueTreeState::ParameterLayout& layout)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20000.f));
+
+        for (int peak = 0; peak < numPeakBands; ++peak)
+        {
+            auto name = "Band " + juce::String(peak + 1);
+
+            layout.add(std::make_unique<juce::AudioParameterFloat>(getPeakParameterID(peak, "Freq"), name + " Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>(getPeakParameterID(peak, "Gain"), name + " Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>(getPeakParameterID(peak, "Quality"), name + " Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+        }
+
+        juce::StringArray stringArray;
+        for (int i = 0; i < 4; i++)
+        {
+            juce::String str;
+            str << (12 + i * 12);
+            str << " db/Oct";
+            stringArray.add(str);
+        }
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode", juce::StringArray{ "Minimum Phase", "Linear Phase" }, MinimumPhase));
+        layout.add(std::make_unique<juce::AudioParameterChoice>("Linear Phase Quality", "Linear Phase Quality", LinearPhaseFilter::getQualityNames(), 1));
+
+        //added after the original parameters so that hosts addressing them by index are unaffected
+        for (int peak = 0; peak < numPeakBands; ++peak)
+            layout.add(std::make_unique<juce::AudioParameterChoice>(getPeakParameterID(peak, "Topology"), "Band " + juce::String(peak + 1) + " Topology",
+                                                                    juce::StringArray{ "Biquad", "State Variable" }, 0));
+
+        for (int peak = 0; peak < numPeakBands; ++peak)
+        {
+            auto name = "Band " + juce::String(peak + 1);
+
+            layout.add(std::make_unique<juce::AudioParameterBool>(getPeakParameterID(peak, "Dynamic"), name + " Dynamic", false));
+            layout.add(std::make_unique<juce::AudioParameterFloat>(getPeakParameterID(peak, "Threshold"), name + " Threshold", juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f), -24.f));
+            layout.add(std::make_unique<juce::AudioParameterFloat>(getPeakParameterID(peak, "Range"), name + " Range", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), -6.f));
+        }
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>("Dynamics Attack", "Dynamics Attack", juce::NormalisableRange<float>(0.1f, 100.f, 0.1f, 0.4f), 5.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>("Dynamics Release", "Dynamics Release", juce::NormalisableRange<float>(5.f, 1000.f, 1.f, 0.4f), 100.f));
+        layout.add(std::make_unique<juce::AudioParameterBool>("Sidechain", "Sidechain", false));
+    }
+};
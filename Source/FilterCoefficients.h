@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    FilterCoefficients.h
+    Plain coefficient containers shared between the design thread and the
+    audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//number of peak bands between the two cuts, the whole band model is generated from it
+#ifndef SIMPLEEQ_NUM_PEAK_BANDS
+ #define SIMPLEEQ_NUM_PEAK_BANDS 4
+#endif
+
+enum ChainPositions
+{
+    LowCut,
+    Peak1,
+    HighCut = Peak1 + SIMPLEEQ_NUM_PEAK_BANDS,
+    NumChainPositions
+};
+
+constexpr int numPeakBands = HighCut - Peak1;
+
+//normalised biquad coefficients (a0 == 1), in the same order as juce::dsp::IIR::Coefficients stores them.
+//always designed in double, the float path rounds them when it gathers a block's sections
+struct BiquadCoefficients
+{
+    double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+};
+
+struct BandCoefficients
+{
+    static constexpr int maxSections = 4;
+
+    std::array<BiquadCoefficients, maxSections> sections;
+    int numSections{ 1 };
+
+    //true when the band is effectively unity (0 dB peak, or a cut measured flat from 20 Hz to 20 kHz)
+    bool bypassed{ false };
+
+    //a peak run by StateVariableBands after the cascade. Still designed, for the display and
+    //the tail, but never packed into the cascade
+    bool stateVariable{ false };
+
+    //a dynamic peak runs in DynamicBands, which moves between sections[0] (the band at rest) and
+    //rangeSection (the band at full range) as its detector, listening through detectorSection, opens
+    bool dynamic{ false };
+    BiquadCoefficients rangeSection, detectorSection;
+
+    //bumped every time the band is redesigned, so the audio thread can skip unchanged bands
+    juce::uint32 version{ 0 };
+};
+
+//every active section of the chain packed struct-of-arrays in processing order
+struct CascadeCoefficients
+{
+    //a peak is a single section, the cuts need up to BandCoefficients::maxSections each
+    static constexpr int maxSections = 2 * BandCoefficients::maxSections + numPeakBands;
+    static_assert(maxSections <= 32, "slot masks are 32 bits wide");
+
+    static constexpr int getFirstSlot(int band) noexcept
+    {
+        return band == LowCut  ? 0
+             : band == HighCut ? BandCoefficients::maxSections + numPeakBands
+                               : BandCoefficients::maxSections + (band - Peak1);
+    }
+
+    std::array<double, maxSections> b0{}, b1{}, b2{}, a1{}, a2{};
+
+    //fixed state slot (getFirstSlot(band) + section) of each packed section
+    std::array<int, maxSections> slots{};
+    int numSections{ 0 };
+    juce::uint32 activeSlotMask{ 0 };
+
+    //sections still in the list only so the cascade can fade them out before they are dropped
+    juce::uint32 fadingOutSlotMask{ 0 };
+
+    //samples for the impulse response of the whole cascade to decay by tailDecibels, from its pole radii
+    double tailSamples{ 0.0 };
+    static constexpr double tailDecibels = 120.0;
+
+    //length of the crossfade used when a section switches in or out
+    static constexpr double fadeTimeSeconds = 0.01;
+};
+
+struct CoefficientSet
+{
+    std::array<BandCoefficients, NumChainPositions> bands;
+    CascadeCoefficients cascade;
+    double sampleRate = 0.0;
+};
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    LinearPhaseFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseFilter.h"
+
+juce::StringArray LinearPhaseFilter::getQualityNames()
+{
+    juce::StringArray names;
+
+    for (int i = 0; i < numQualities; ++i)
+        names.add(juce::String(getKernelLength(i)) + " taps");
+
+    return names;
+}
+
+void LinearPhaseFilter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    const juce::ScopedLock sl(kernelLock);
+
+    convolutions.clear();
+    conversionBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+
+    for (juce::uint32 channel = 0; channel < spec.numChannels; channel += 2)
+    {
+        auto pairSpec = spec;
+        pairSpec.numChannels = juce::jmin(2u, spec.numChannels - channel);
+
+        convolutions.add(new juce::dsp::Convolution(juce::dsp::Convolution::NonUniform{ headSize }, *messageQueue))->prepare(pairSpec);
+    }
+
+    //a fresh convolution starts without a kernel, give it the last one designed
+    loadKernel();
+}
+
+void LinearPhaseFilter::reset() noexcept
+{
+    for (auto* convolution : convolutions)
+        convolution->reset();
+}
+
+int LinearPhaseFilter::getLatencySamples(int qualityIndex) const noexcept
+{
+    auto convolutionLatency = convolutions.isEmpty() ? 0 : convolutions.getUnchecked(0)->getLatency();
+    return getKernelLength(qualityIndex) / 2 + convolutionLatency;
+}
+
+void LinearPhaseFilter::design(const CascadeCoefficients& cascade, int kernelLength, double sampleRate)
+{
+    jassert(juce::isPowerOfTwo(kernelLength));
+
+    auto order = juce::roundToInt(std::log2((double) kernelLength));
+    juce::dsp::FFT fft(order);
+
+    //zero phase spectrum holding the cascade's magnitude at every bin
+    std::vector<std::complex<float>> spectrum((size_t) kernelLength), impulse((size_t) kernelLength);
+
+    for (int bin = 0; bin <= kernelLength / 2; ++bin)
+    {
+        auto w = juce::MathConstants<double>::twoPi * bin / kernelLength;
+        std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+        double magnitude = 1.0;
+
+        for (size_t i = 0; i < (size_t) cascade.numSections; ++i)
+        {
+            //sections on their way out are already gone from the response the kernel converges to
+            if ((cascade.fadingOutSlotMask & (1u << cascade.slots[i])) != 0)
+                continue;
+
+            auto numerator = (double) cascade.b0[i] + (double) cascade.b1[i] * z1 + (double) cascade.b2[i] * z2;
+            auto denominator = 1.0 + (double) cascade.a1[i] * z1 + (double) cascade.a2[i] * z2;
+            magnitude *= std::abs(numerator / denominator);
+        }
+
+        spectrum[(size_t) bin] = (float) magnitude;
+
+        if (bin > 0 && bin < kernelLength / 2)
+            spectrum[(size_t) (kernelLength - bin)] = (float) magnitude;
+    }
+
+    fft.perform(spectrum.data(), impulse.data(), true);
+
+    //centre the impulse and window it, which leaves a symmetric kernel with a delay of half its length
+    juce::AudioBuffer<float> newKernel(1, kernelLength);
+    auto* taps = newKernel.getWritePointer(0);
+
+    for (int i = 0; i < kernelLength; ++i)
+    {
+        auto phase = juce::MathConstants<double>::twoPi * i / kernelLength;
+        auto blackman = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+
+        taps[i] = (float) blackman * impulse[(size_t) ((i + kernelLength / 2) % kernelLength)].real();
+    }
+
+    const juce::ScopedLock sl(kernelLock);
+
+    kernel = std::move(newKernel);
+    kernelSampleRate = sampleRate;
+    ++kernelGeneration;
+    loadKernel();
+}
+
+void LinearPhaseFilter::loadKernel()
+{
+    if (kernel.getNumSamples() == 0)
+        return;
+
+    //the convolutions take ownership, so each gets its own copy; the swap happens on the message queue's thread
+    for (auto* convolution : convolutions)
+    {
+        juce::AudioBuffer<float> tagged(1, getLoadedKernelSize());
+        tagged.clear();
+        tagged.copyFrom(0, 0, kernel, 0, 0, kernel.getNumSamples());
+
+        convolution->loadImpulseResponse(std::move(tagged), kernelSampleRate,
+                                         juce::dsp::Convolution::Stereo::no,
+                                         juce::dsp::Convolution::Trim::no,
+                                         juce::dsp::Convolution::Normalise::no);
+    }
+}
+
+int LinearPhaseFilter::getLoadedKernelSize() const noexcept
+{
+    return kernel.getNumSamples() + (int) (kernelGeneration % (juce::uint32) numGenerationTags);
+}
+
+bool LinearPhaseFilter::waitUntilKernelLoaded(int timeoutMs)
+{
+    int kernelSize = 0;
+
+    {
+        const juce::ScopedLock sl(kernelLock);
+
+        if (kernel.getNumSamples() > 0)
+            kernelSize = getLoadedKernelSize();
+    }
+
+    //the size tells the generation apart from the ones before it, unless numGenerationTags of them are still queued
+    auto isLoaded = [&]
+    {
+        return std::all_of(convolutions.begin(), convolutions.end(),
+                           [&](juce::dsp::Convolution* convolution) { return convolution->getCurrentIRSize() == kernelSize; });
+    };
+
+    auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+    //a convolution only swaps in a kernel the queue has prepared while it is processing
+    while (kernelSize > 0 && ! isLoaded())
+    {
+        if (juce::Time::getMillisecondCounter() >= deadline)
+            return false;
+
+        conversionBuffer.clear();
+        juce::dsp::AudioBlock<float> silence(conversionBuffer);
+        process(juce::dsp::ProcessContextReplacing<float>(silence));
+        juce::Thread::sleep(1);
+    }
+
+    //ends the crossfade from the empty kernel, so the first real sample goes through the new one alone
+    reset();
+    return true;
+}
+
+void LinearPhaseFilter::process(const juce::dsp::ProcessContextReplacing<float>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numChannels = block.getNumChannels();
+
+    for (size_t channel = 0, pair = 0; channel < numChannels && pair < (size_t) convolutions.size(); channel += 2, ++pair)
+    {
+        auto pairBlock = block.getSubsetChannelBlock(channel, juce::jmin((size_t) 2, numChannels - channel));
+        juce::dsp::ProcessContextReplacing<float> pairContext(pairBlock);
+        pairContext.isBypassed = context.isBypassed;
+
+        convolutions.getUnchecked((int) pair)->process(pairContext);
+    }
+}
+
+void LinearPhaseFilter::process(const juce::dsp::ProcessContextReplacing<double>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numChannels = juce::jmin(block.getNumChannels(), (size_t) conversionBuffer.getNumChannels());
+    auto numSamples = juce::jmin(block.getNumSamples(), (size_t) conversionBuffer.getNumSamples());
+
+    jassert(numSamples == block.getNumSamples());
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto* source = block.getChannelPointer(channel);
+        auto* destination = conversionBuffer.getWritePointer((int) channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            destination[i] = (float) source[i];
+    }
+
+    juce::dsp::AudioBlock<float> floatBlock(conversionBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+    juce::dsp::ProcessContextReplacing<float> floatContext(floatBlock);
+    floatContext.isBypassed = context.isBypassed;
+    process(floatContext);
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto* source = floatBlock.getChannelPointer(channel);
+        auto* destination = block.getChannelPointer(channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            destination[i] = (double) source[i];
+    }
+}
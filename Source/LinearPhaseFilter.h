@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    LinearPhaseFilter.h
+    FIR alternative to the biquad cascade with the same magnitude response.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+enum PhaseMode
+{
+    MinimumPhase,
+    LinearPhase
+};
+
+/**
+    Turns the magnitude response of a CascadeCoefficients into a symmetric FIR
+    kernel and runs it through juce::dsp::Convolution, which partitions the
+    kernel non-uniformly and crossfades whenever a new one is loaded. Kernels
+    are designed on the coefficient design thread, the audio thread only calls
+    process(). The kernel is centred, so the latency is half its length.
+*/
+class LinearPhaseFilter
+{
+public:
+    //kernel length for each entry of the "Linear Phase Quality" parameter
+    static int getKernelLength(int qualityIndex) noexcept  { return minimumKernelLength << juce::jlimit(0, numQualities - 1, qualityIndex); }
+    static juce::StringArray getQualityNames();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    //samples of delay for the given quality, including any latency of the convolution itself
+    int getLatencySamples(int qualityIndex) const noexcept;
+
+    //design thread only, replaces the kernel with one matching the cascade's magnitude response
+    void design(const CascadeCoefficients& cascade, int kernelLength, double sampleRate);
+
+    //offline use only, instead of process(): kernels reach the convolutions on a background thread, this
+    //runs silence through them until the last one designed is the one in use. Returns false on timeout
+    bool waitUntilKernelLoaded(int timeoutMs);
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) noexcept;
+
+    //dsp::Convolution only runs in float, so double blocks go through a preallocated float copy
+    void process(const juce::dsp::ProcessContextReplacing<double>& context) noexcept;
+
+private:
+    void loadKernel();
+    int getLoadedKernelSize() const noexcept;
+
+    static constexpr int minimumKernelLength = 2048;
+    static constexpr int numQualities = 4;
+
+    //partition size of the direct part, later partitions grow to keep long kernels cheap
+    static constexpr int headSize = 256;
+
+    //the convolutions only tell the size of the kernel they run, so each generation is padded with
+    //generation % numGenerationTags zeros. Past the end of a centred kernel they change neither its
+    //response nor its latency, but two kernels of the same length designed in a row stay apart
+    static constexpr int numGenerationTags = 8;
+
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> messageQueue;
+
+    //dsp::Convolution handles at most two channels, so every pair of channels gets its own
+    juce::OwnedArray<juce::dsp::Convolution> convolutions;
+
+    juce::AudioBuffer<float> conversionBuffer;
+
+    juce::CriticalSection kernelLock;
+    juce::AudioBuffer<float> kernel;
+    double kernelSampleRate = 0.0;
+    juce::uint32 kernelGeneration = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinearPhaseFilter)
+};
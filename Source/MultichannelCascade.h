@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    MultichannelCascade.h
+    Runs the BiquadCascade over any number of channels sharing one set of
+    coefficients.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+#include "ChannelWorkerPool.h"
+
+/**
+    Splits the channels of a block into groups of as many channels as SampleType
+    has lanes. Each group is interleaved so that a single BiquadCascade filters
+    all of its channels at once, with the filter state of the group stored one
+    lane per channel. With a scalar SampleType every channel is its own group and
+    is filtered in place.
+
+    Groups are independent, so a wide bus can spread them over a
+    ChannelWorkerPool; every thread then interleaves into its own buffer.
+*/
+template <typename SampleType>
+class MultichannelCascade
+{
+public:
+    using NumericType = typename BiquadCascade<SampleType>::NumericType;
+    static constexpr size_t lanes = sizeof(SampleType) / sizeof(NumericType);
+
+    //numThreads is the pool's worker count plus the calling thread
+    void prepare(const juce::dsp::ProcessSpec& spec, int numThreads = 1)
+    {
+        numChannels = (size_t) spec.numChannels;
+        maximumBlockSize = (size_t) spec.maximumBlockSize;
+
+        auto numGroups = (numChannels + lanes - 1) / lanes;
+        auto groupSpec = spec;
+        groupSpec.numChannels = 1;
+
+        groups.clear();
+
+        for (size_t i = 0; i < numGroups; ++i)
+            groups.add(new BiquadCascade<SampleType>())->prepare(groupSpec);
+
+        interleavedData.clear();
+        interleaved.clear();
+
+        if constexpr (lanes > 1)
+        {
+            interleavedData.resize((size_t) juce::jmax(1, numThreads));
+
+            for (auto& data : interleavedData)
+                interleaved.push_back(juce::dsp::AudioBlock<SampleType>(data, 1, maximumBlockSize));
+        }
+    }
+
+    void reset() noexcept
+    {
+        for (auto* group : groups)
+            group->reset();
+    }
+
+    NumericType getStateMagnitude() const noexcept
+    {
+        NumericType peak (0);
+
+        for (auto* group : groups)
+            peak = juce::jmax(peak, group->getStateMagnitude());
+
+        return peak;
+    }
+
+    //every channel group is linked to the same coefficients
+    void setCoefficients(const CascadeCoefficients& newCoefficients) noexcept
+    {
+        for (auto* group : groups)
+            group->setCoefficients(newCoefficients);
+    }
+
+    void process(const juce::dsp::ProcessContextReplacing<NumericType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        auto channelsToProcess = juce::jmin(block.getNumChannels(), numChannels);
+
+        jassert(block.getNumSamples() <= maximumBlockSize);
+
+        if (context.isBypassed)
+            return;
+
+        processGroups(block, 0, getNumGroups(channelsToProcess), channelsToProcess, 0);
+    }
+
+    //the same, with the groups spread over the pool's workers and the calling thread
+    void process(const juce::dsp::ProcessContextReplacing<NumericType>& context, ChannelWorkerPool& pool) noexcept
+    {
+        struct GroupJob : public ChannelWorkerPool::Job
+        {
+            GroupJob(MultichannelCascade& cascadeToRun, const juce::dsp::AudioBlock<NumericType>& blockToProcess, size_t channels)
+                : cascade(cascadeToRun), block(blockToProcess), channelsToProcess(channels) {}
+
+            //one group per task, so a worker that stalls holds up at most the group it is in the middle of
+            void run(int task, int thread) noexcept override
+            {
+                cascade.processGroups(block, (size_t) task, (size_t) task + 1, channelsToProcess, (size_t) thread);
+            }
+
+            MultichannelCascade& cascade;
+            const juce::dsp::AudioBlock<NumericType>& block;
+            size_t channelsToProcess;
+        };
+
+        auto& block = context.getOutputBlock();
+        auto channelsToProcess = juce::jmin(block.getNumChannels(), numChannels);
+        auto numGroupsToProcess = getNumGroups(channelsToProcess);
+
+        jassert(block.getNumSamples() <= maximumBlockSize);
+        jassert(lanes == 1 || (size_t) pool.getNumThreads() < interleaved.size());
+
+        if (context.isBypassed || numGroupsToProcess == 0)
+            return;
+
+        GroupJob job(*this, block, channelsToProcess);
+        pool.run(job, (int) numGroupsToProcess);
+    }
+
+private:
+    static size_t getNumGroups(size_t channels) noexcept  { return (channels + lanes - 1) / lanes; }
+
+    void processGroups(const juce::dsp::AudioBlock<NumericType>& block, size_t firstGroup, size_t endGroup,
+                       size_t channelsToProcess, size_t thread) noexcept
+    {
+        auto numSamples = block.getNumSamples();
+
+        for (auto group = firstGroup; group < endGroup; ++group)
+        {
+            auto firstChannel = group * lanes;
+
+            if constexpr (lanes == 1)
+            {
+                groups.getUnchecked((int) group)->processSamples(block.getChannelPointer(firstChannel), numSamples);
+            }
+            else
+            {
+                auto groupChannels = juce::jmin(lanes, channelsToProcess - firstChannel);
+                auto& buffer = interleaved[thread];
+
+                interleaveChannels(buffer, block, firstChannel, groupChannels, numSamples);
+                groups.getUnchecked((int) group)->processSamples(buffer.getChannelPointer(0), numSamples);
+                deinterleaveChannels(buffer, block, firstChannel, groupChannels, numSamples);
+            }
+        }
+    }
+
+    static void interleaveChannels(juce::dsp::AudioBlock<SampleType>& buffer, const juce::dsp::AudioBlock<NumericType>& block,
+                                   size_t firstChannel, size_t groupChannels, size_t numSamples) noexcept
+    {
+        auto* interleavedSamples = reinterpret_cast<NumericType*>(buffer.getChannelPointer(0));
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            //a partial group's spare lanes are fed silence, not whatever the previous group left behind
+            if (lane >= groupChannels)
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                    interleavedSamples[i * lanes + lane] = NumericType (0);
+
+                continue;
+            }
+
+            auto* source = block.getChannelPointer(firstChannel + lane);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                interleavedSamples[i * lanes + lane] = source[i];
+        }
+    }
+
+    static void deinterleaveChannels(const juce::dsp::AudioBlock<SampleType>& buffer, const juce::dsp::AudioBlock<NumericType>& block,
+                                     size_t firstChannel, size_t groupChannels, size_t numSamples) noexcept
+    {
+        auto* interleavedSamples = reinterpret_cast<const NumericType*>(buffer.getChannelPointer(0));
+
+        for (size_t lane = 0; lane < groupChannels; ++lane)
+        {
+            auto* destination = block.getChannelPointer(firstChannel + lane);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                destination[i] = interleavedSamples[i * lanes + lane];
+        }
+    }
+
+    juce::OwnedArray<BiquadCascade<SampleType>> groups;
+    size_t numChannels = 0, maximumBlockSize = 0;
+
+    //one interleaving buffer per thread that can process groups
+    std::vector<juce::HeapBlock<char>> interleavedData;
+    std::vector<juce::dsp::AudioBlock<SampleType>> interleaved;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultichannelCascade)
+};
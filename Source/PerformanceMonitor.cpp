@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceMonitor.h"
+
+void PerformanceMonitor::setEnabled(bool shouldBeEnabled) noexcept
+{
+    enabled.store(shouldBeEnabled);
+}
+
+void PerformanceMonitor::push(const BlockTiming& timing) noexcept
+{
+    //never waits for the consumer, a full FIFO just drops the block
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 > 0)
+        timings[(size_t) scope.startIndex1] = timing;
+    else if (scope.blockSize2 > 0)
+        timings[(size_t) scope.startIndex2] = timing;
+    else
+        ++dropped;
+}
+
+PerformanceMonitor::Stats PerformanceMonitor::collect()
+{
+    if (history.empty())
+        history.reserve(historySize);
+
+    auto toMicroseconds = [](juce::int64 ticks) { return 1.0e6 * juce::Time::highResolutionTicksToSeconds(ticks); };
+
+    for (auto numReady = fifo.getNumReady(); numReady > 0; --numReady)
+    {
+        const auto scope = fifo.read(1);
+        auto& timing = timings[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+
+        BlockSummary summary { toMicroseconds(timing.end - timing.start),
+                               toMicroseconds(timing.coefficientsDone - timing.start),
+                               toMicroseconds(timing.end - timing.coefficientsDone) };
+
+        auto budgetMicroseconds = timing.sampleRate > 0.0 ? 1.0e6 * timing.numSamples / timing.sampleRate : 0.0;
+
+        if (summary.total > budgetMicroseconds)
+            ++overruns;
+
+        budgetMicrosecondsTotal += budgetMicroseconds;
+        blockMicrosecondsTotal += summary.total;
+
+        if ((int) history.size() < historySize)
+            history.push_back(summary);
+        else
+            history[(size_t) historyWritePosition] = summary;
+
+        historyWritePosition = (historyWritePosition + 1) % historySize;
+    }
+
+    Stats stats;
+    stats.numBlocks = (int) history.size();
+    stats.overruns = overruns;
+    stats.dropped = dropped.load();
+    stats.budgetPercent = budgetMicrosecondsTotal > 0.0 ? 100.0 * blockMicrosecondsTotal / budgetMicrosecondsTotal : 0.0;
+
+    if (history.empty())
+        return stats;
+
+    std::vector<double> totals;
+    totals.reserve(history.size());
+
+    for (auto& summary : history)
+    {
+        totals.push_back(summary.total);
+        stats.meanMicroseconds += summary.total;
+        stats.meanCoefficientMicroseconds += summary.coefficients;
+        stats.meanFilterMicroseconds += summary.filter;
+    }
+
+    stats.meanMicroseconds /= (double) history.size();
+    stats.meanCoefficientMicroseconds /= (double) history.size();
+    stats.meanFilterMicroseconds /= (double) history.size();
+
+    auto p99Index = (size_t) ((double) (totals.size() - 1) * 0.99);
+    std::nth_element(totals.begin(), totals.begin() + (long) p99Index, totals.end());
+    stats.p99Microseconds = totals[p99Index];
+    stats.worstMicroseconds = *std::max_element(totals.begin(), totals.end());
+
+    return stats;
+}
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.h
+    Real-time safe timing of processBlock, read from the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//compiles the timing code in, it still has to be switched on at runtime with setEnabled
+#ifndef SIMPLEEQ_ENABLE_PROFILING
+ #define SIMPLEEQ_ENABLE_PROFILING 1
+#endif
+
+/**
+    The audio thread timestamps each block and its stages into a preallocated
+    lock-free FIFO; collect() drains it on a consumer thread and summarises the
+    most recent blocks. With SIMPLEEQ_ENABLE_PROFILING set to 0, or while disabled
+    at runtime, a block costs at most one relaxed atomic load.
+*/
+class PerformanceMonitor
+{
+public:
+    struct Stats
+    {
+        int numBlocks = 0;
+        double meanMicroseconds = 0.0, p99Microseconds = 0.0, worstMicroseconds = 0.0;
+        double meanCoefficientMicroseconds = 0.0, meanFilterMicroseconds = 0.0;
+
+        //mean block time as a share of the time the block represents
+        double budgetPercent = 0.0;
+
+        //blocks that took longer than their own duration, since profiling was switched on
+        juce::int64 overruns = 0, dropped = 0;
+    };
+
+    PerformanceMonitor() = default;
+
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    bool isEnabled() const noexcept
+    {
+       #if SIMPLEEQ_ENABLE_PROFILING
+        return enabled.load(std::memory_order_relaxed);
+       #else
+        return false;
+       #endif
+    }
+
+    /** Create one on the stack at the top of processBlock. */
+    class BlockTimer
+    {
+    public:
+        explicit BlockTimer(PerformanceMonitor& monitorToUse) noexcept
+           #if SIMPLEEQ_ENABLE_PROFILING
+            : monitor(monitorToUse.isEnabled() ? &monitorToUse : nullptr),
+              start(monitor != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+           #endif
+        {
+            juce::ignoreUnused(monitorToUse);
+        }
+
+        void coefficientsUpdated() noexcept
+        {
+           #if SIMPLEEQ_ENABLE_PROFILING
+            if (monitor != nullptr)
+                coefficientsDone = juce::Time::getHighResolutionTicks();
+           #endif
+        }
+
+        void finished(int numSamples, double sampleRate) noexcept
+        {
+           #if SIMPLEEQ_ENABLE_PROFILING
+            if (monitor != nullptr)
+                monitor->push({ start, coefficientsDone != 0 ? coefficientsDone : start,
+                                juce::Time::getHighResolutionTicks(), numSamples, sampleRate });
+           #else
+            juce::ignoreUnused(numSamples, sampleRate);
+           #endif
+        }
+
+    private:
+       #if SIMPLEEQ_ENABLE_PROFILING
+        PerformanceMonitor* monitor;
+        juce::int64 start, coefficientsDone = 0;
+       #endif
+    };
+
+    /** Call from a single consumer thread (e.g. an editor's timer). */
+    Stats collect();
+
+private:
+    struct BlockTiming
+    {
+        juce::int64 start, coefficientsDone, end;
+        int numSamples;
+        double sampleRate;
+    };
+
+    struct BlockSummary
+    {
+        double total, coefficients, filter;
+    };
+
+    void push(const BlockTiming& timing) noexcept;
+
+    static constexpr int fifoSize = 1024;
+    static constexpr int historySize = 4096;
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<juce::int64> dropped{ 0 };
+
+    juce::AbstractFifo fifo{ fifoSize };
+    std::array<BlockTiming, fifoSize> timings;
+
+    //consumer side only
+    std::vector<BlockSummary> history;
+    int historyWritePosition = 0;
+    juce::int64 overruns = 0;
+    double budgetMicrosecondsTotal = 0.0, blockMicrosecondsTotal = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceMonitor)
+};
@@ -13,9 +13,29 @@
 SimpleEqAudioProcessorEditor::SimpleEqAudioProcessorEditor (SimpleEqAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    addAndMakeVisible(spectrumDisplay);
+    addAndMakeVisible(parameterEditor);
+
+    profileButton.setToggleState(audioProcessor.getPerformanceMonitor().isEnabled(), juce::dontSendNotification);
+    profileButton.onClick = [this] { audioProcessor.getPerformanceMonitor().setEnabled(profileButton.getToggleState()); };
+    profileButton.setEnabled(SIMPLEEQ_ENABLE_PROFILING != 0);
+    addAndMakeVisible(profileButton);
+
+    //FontOptions replaced the Font constructors in JUCE 8
+   #if JUCE_MAJOR_VERSION >= 8
+    performanceLabel.setFont(juce::FontOptions(13.0f));
+   #else
+    performanceLabel.setFont(juce::Font(13.0f));
+   #endif
+    performanceLabel.setJustificationType(juce::Justification::topLeft);
+    addAndMakeVisible(performanceLabel);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (juce::jmax(600, parameterEditor.getWidth()), spectrumHeight + parameterEditor.getHeight() + performanceHeight);
+
+    startTimerHz(4);
+    timerCallback();
 }
 
 SimpleEqAudioProcessorEditor::~SimpleEqAudioProcessorEditor()
@@ -27,14 +47,37 @@ void SimpleEqAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World! Im yohan this is my first build", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void SimpleEqAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds();
+    auto performanceArea = bounds.removeFromBottom(performanceHeight).reduced(4);
+
+    spectrumDisplay.setBounds(bounds.removeFromTop(spectrumHeight));
+    parameterEditor.setBounds(bounds);
+    profileButton.setBounds(performanceArea.removeFromLeft(80));
+    performanceLabel.setBounds(performanceArea);
+}
+
+void SimpleEqAudioProcessorEditor::timerCallback()
+{
+    auto cache = audioProcessor.getCoefficientCacheStats();
+    auto cacheText = "Cache: " + juce::String(100.0 * cache.getHitRate(), 1) + "% hits, "
+                   + juce::String((juce::int64) cache.numEntries) + " entries, " + juce::String((juce::int64) cache.memoryBytes / 1024) + " kB";
+
+    if (! audioProcessor.getPerformanceMonitor().isEnabled())
+    {
+        performanceLabel.setText(cacheText, juce::dontSendNotification);
+        return;
+    }
+
+    auto stats = audioProcessor.getPerformanceMonitor().collect();
+
+    auto text = "Block: mean " + juce::String(stats.meanMicroseconds, 1) + " us, p99 " + juce::String(stats.p99Microseconds, 1)
+              + " us, " + juce::String(stats.budgetPercent, 2) + "% of budget, " + juce::String(stats.overruns) + " over deadline"
+              + "\nCoefficients " + juce::String(stats.meanCoefficientMicroseconds, 1) + " us, filtering "
+              + juce::String(stats.meanFilterMicroseconds, 1) + " us.  " + cacheText;
+
+    performanceLabel.setText(text, juce::dontSendNotification);
 }
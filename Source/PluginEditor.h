@@ -10,11 +10,13 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumDisplay.h"
 
 //==============================================================================
 /**
 */
-class SimpleEqAudioProcessorEditor  : public juce::AudioProcessorEditor
+class SimpleEqAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                      private juce::Timer
 {
 public:
     SimpleEqAudioProcessorEditor (SimpleEqAudioProcessor&);
@@ -25,9 +27,21 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleEqAudioProcessor& audioProcessor;
 
+    SpectrumDisplay spectrumDisplay{ audioProcessor };
+    juce::GenericAudioProcessorEditor parameterEditor{ audioProcessor };
+
+    //block timing readout, only collects while the toggle is on
+    juce::ToggleButton profileButton{ "Profile" };
+    juce::Label performanceLabel;
+
+    static constexpr int spectrumHeight = 220;
+    static constexpr int performanceHeight = 48;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEqAudioProcessorEditor)
 };
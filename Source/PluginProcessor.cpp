@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Presets.h"
 
 //==============================================================================
 SimpleEqAudioProcessor::SimpleEqAudioProcessor()
@@ -16,16 +17,32 @@ SimpleEqAudioProcessor::SimpleEqAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            apvts.addParameterListener(ranged->paramID, this);
+
+    std::vector<ChainSettings> presetSettings;
+
+    for (auto& preset : getFactoryPresets())
+        presetSettings.push_back(snapToParameters(apvts, preset.settings));
+
+    coefficientWorker.setPresets(presetSettings);
 }
 
 SimpleEqAudioProcessor::~SimpleEqAudioProcessor()
 {
+    cancelPendingUpdate();
+
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            apvts.removeParameterListener(ranged->paramID, this);
 }
 
 //==============================================================================
@@ -63,27 +80,42 @@ bool SimpleEqAudioProcessor::isMidiEffect() const
 
 double SimpleEqAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    //the linear phase kernel rings for its whole length, the cascade for as long as its slowest poles need
+    if (parameters.phaseMode->load() >= 0.5f && getSampleRate() > 0.0)
+        return LinearPhaseFilter::getKernelLength((int) parameters.linearPhaseQuality->load()) / getSampleRate();
+
+    return cascadeTailSeconds.load();
 }
 
 int SimpleEqAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return (int) getFactoryPresets().size();
 }
 
 int SimpleEqAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void SimpleEqAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow(index, getNumPrograms()))
+        return;
+
+    currentProgram = index;
+    setChainSettings(apvts, getFactoryPresets()[(size_t) index].settings);
+
+    //the preset was designed ahead of time, so this only publishes it. Until then the
+    //parameter changes above go through the normal design path
+    coefficientWorker.loadPreset(index);
 }
 
 const juce::String SimpleEqAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (! juce::isPositiveAndBelow(index, getNumPrograms()))
+        return {};
+
+    return getFactoryPresets()[(size_t) index].name;
 }
 
 void SimpleEqAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -98,19 +130,47 @@ void SimpleEqAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
 	juce::dsp::ProcessSpec spec;
 	spec.maximumBlockSize = samplesPerBlock;
 	spec.sampleRate = sampleRate;
-    spec.numChannels = 1;  //only mono chain is supported in dsp
-
-	leftChain.prepare(spec);
-	rightChain.prepare(spec);
-
-	updateFilters();
-
+    spec.numChannels = (juce::uint32) getMainBusNumInputChannels();
+
+    auto idleSpec = spec;
+    idleSpec.numChannels = 0;
+
+    //the pool only runs for buses wide enough to gain from it
+    auto numPoolThreads = (int) spec.numChannels >= minParallelChannels ? numWorkerThreads : 0;
+    workerPool.prepare(numPoolThreads, (int) spec.numChannels, samplesPerBlock / juce::jmax(1.0, sampleRate));
+
+	chain.prepare(isUsingDoublePrecision() ? idleSpec : spec, numPoolThreads + 1);
+    doubleChain.prepare(isUsingDoublePrecision() ? spec : idleSpec, numPoolThreads + 1);
+    stateVariableBands.prepare(isUsingDoublePrecision() ? idleSpec : spec);
+    doubleStateVariableBands.prepare(isUsingDoublePrecision() ? spec : idleSpec);
+    //the detectors listen to the main input or to the sidechain, so they are prepared for the wider of the two
+    auto* sidechainBus = getBus(true, 1);
+    auto numDetectorChannels = juce::jmax((int) spec.numChannels, sidechainBus != nullptr ? sidechainBus->getNumberOfChannels() : 0);
+
+    dynamicBands.prepare(isUsingDoublePrecision() ? idleSpec : spec, isUsingDoublePrecision() ? 0 : numDetectorChannels);
+    doubleDynamicBands.prepare(isUsingDoublePrecision() ? spec : idleSpec, isUsingDoublePrecision() ? numDetectorChannels : 0);
+    linearPhase.prepare(spec);
+    spectrumAnalyzer.prepare(sampleRate);
+    linearPhaseActive = parameters.phaseMode->load() >= 0.5f;
+    phaseSwitchGain.reset(sampleRate, phaseSwitchFadeSeconds);
+    phaseSwitchGain.setCurrentAndTargetValue(1.0f);
+    silentSamples = 0;
+    suspended = false;
+
+    //sample rate may have changed, so every band needs a fresh design
+    coefficientWorker.prepare(sampleRate);
+
+    if (auto* coefficients = coefficientWorker.getNewCoefficients())
+	    updateFilters(*coefficients);
+
+    updateLatency();
 }
 
 void SimpleEqAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    workerPool.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -120,18 +180,21 @@ bool SimpleEqAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout works, from mono up to large immersive and ambisonic buses,
+    // every channel goes through the same cascade.
+    auto mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain only feeds the dynamic bands' detectors, any width will do
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > maxNumChannels)
+        return false;
    #endif
 
     return true;
@@ -139,11 +202,16 @@ bool SimpleEqAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 }
 #endif
 
-void SimpleEqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+template <typename FloatType>
+void SimpleEqAudioProcessor::processBuffer (juce::AudioBuffer<FloatType>& buffer, MultichannelCascade<ChainSampleType<FloatType>>& cascade,
+                                            StateVariableBands<FloatType>& stateVariable, DynamicBands<FloatType>& dynamic)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    PerformanceMonitor::BlockTimer blockTimer(performanceMonitor);
+
+    //only the main bus is filtered, the sidechain channels that follow it are just listened to
+    auto totalNumInputChannels  = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -154,188 +222,298 @@ void SimpleEqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-	//update filters
-	updateFilters();
+	//pick up coefficients designed on the background thread, if any
+    if (auto* coefficients = coefficientWorker.getNewCoefficients())
+	    updateFilters(*coefficients);
+
+    blockTimer.coefficientsUpdated();
 
     //Processing Audio
-	juce::dsp::AudioBlock<float> block(buffer);
-	auto leftBlock = block.getSingleChannelBlock(0);
-	auto rightBlock = block.getSingleChannelBlock(1);
+	juce::dsp::AudioBlock<FloatType> block(buffer);
+    auto inputBlock = block.getSubsetChannelBlock(0, (size_t) totalNumInputChannels);
 
-	juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-	juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+	juce::dsp::ProcessContextReplacing<FloatType> context(inputBlock);
+    spectrumAnalyzer.push(SpectrumAnalyzer::Pre, inputBlock);
 
-	leftChain.process(leftContext);
-	rightChain.process(rightContext);
-    //Processing End
-}
+    //the two paths differ in latency, so the output fades out, they swap while it is silent and it fades back
+    //in. Whichever path takes over starts from clean state rather than from whatever it held when it was last used
+    auto useLinearPhase = parameters.phaseMode->load() >= 0.5f;
 
-//==============================================================================
-bool SimpleEqAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
+    if (useLinearPhase != linearPhaseActive && phaseSwitchGain.getCurrentValue() == 0.0f)
+    {
+        linearPhaseActive = useLinearPhase;
+
+        if (linearPhaseActive)
+        {
+            linearPhase.reset();
+        }
+        else
+        {
+            cascade.reset();
+            stateVariable.reset();
+            dynamic.reset();
+        }
+    }
 
-juce::AudioProcessorEditor* SimpleEqAudioProcessor::createEditor()
-{
-   // return new SimpleEqAudioProcessorEditor (*this);
-	return new juce::GenericAudioProcessorEditor(*this);
-}
+    auto inputSilent = true;
 
-//==============================================================================
-void SimpleEqAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-}
+    for (int channel = 0; channel < totalNumInputChannels && inputSilent; ++channel)
+        inputSilent = buffer.getMagnitude(channel, 0, buffer.getNumSamples()) < (FloatType) silenceThreshold;
 
-void SimpleEqAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-}
+    if (! inputSilent)
+    {
+        silentSamples = 0;
+        suspended = false;
+    }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
-{
-    ChainSettings settings;
+    if (! suspended)
+    {
+        //the detectors listen to the input before the EQ has touched it
+        auto dynamicActive = ! linearPhaseActive && dynamic.isActive();
+
+        if (dynamicActive)
+        {
+            dynamic.setTiming(parameters.dynamicsAttack->load(), parameters.dynamicsRelease->load());
+
+            for (int peak = 0; peak < numPeakBands; ++peak)
+                dynamic.setThreshold(peak, parameters.peaks[(size_t) peak].threshold->load());
+
+            dynamic.analyse(getDetectorBlock(block, inputBlock));
+        }
+
+        if (linearPhaseActive)
+            linearPhase.process(context);
+        else
+            processCascade(inputBlock, cascade);
+
+        if (dynamicActive)
+            dynamic.process(inputBlock);
+
+        //its targets come straight from the parameters, the smoothing takes care of the rest
+        if (! linearPhaseActive && stateVariable.isActive())
+        {
+            for (int peak = 0; peak < numPeakBands; ++peak)
+            {
+                auto& handles = parameters.peaks[(size_t) peak];
+                stateVariable.setTargets(peak, handles.freq->load(), handles.gain->load(), handles.quality->load());
+            }
+
+            stateVariable.process(inputBlock);
+        }
+
+        if (inputSilent)
+        {
+            silentSamples += buffer.getNumSamples();
+
+            //the cascade can also be seen to have gone quiet before its worst case tail is over
+            auto tailSamples = linearPhaseActive ? (double) LinearPhaseFilter::getKernelLength((int) parameters.linearPhaseQuality->load())
+                                                 : cascadeTailSamples;
+            auto rungOut = (double) silentSamples >= tailSamples
+                        || (! linearPhaseActive && cascade.getStateMagnitude() < (FloatType) silenceThreshold
+                                                && stateVariable.getStateMagnitude() < (FloatType) silenceThreshold
+                                                && dynamic.getStateMagnitude() < (FloatType) silenceThreshold);
+
+            if (rungOut)
+            {
+                suspended = true;
+                cascade.reset();
+                stateVariable.reset();
+                dynamic.reset();
+                linearPhase.reset();
+            }
+        }
+    }
 
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
+    //switching back before the fade out is over just fades in again
+    phaseSwitchGain.setTargetValue(useLinearPhase != linearPhaseActive ? 0.0f : 1.0f);
 
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    if (phaseSwitchGain.isSmoothing() || phaseSwitchGain.getCurrentValue() < 1.0f)
+    {
+        for (size_t i = 0; i < inputBlock.getNumSamples(); ++i)
+        {
+            auto gain = (FloatType) phaseSwitchGain.getNextValue();
 
-    settings.peakFreq1 = apvts.getRawParameterValue("Peak1 Freq")->load();
-    settings.peakGainInDecibels1 = apvts.getRawParameterValue("Peak1 Gain")->load();
-    settings.peakQuality1 = apvts.getRawParameterValue("Peak1 Quality")->load();
+            for (size_t channel = 0; channel < inputBlock.getNumChannels(); ++channel)
+                inputBlock.getChannelPointer(channel)[i] *= gain;
+        }
+    }
 
-    settings.peakFreq2 = apvts.getRawParameterValue("Peak2 Freq")->load();
-    settings.peakGainInDecibels2 = apvts.getRawParameterValue("Peak2 Gain")->load();
-    settings.peakQuality2 = apvts.getRawParameterValue("Peak2 Quality")->load();
+    spectrumAnalyzer.push(SpectrumAnalyzer::Post, inputBlock);
+    //Processing End
 
-    settings.peakFreq3 = apvts.getRawParameterValue("Peak3 Freq")->load();
-    settings.peakGainInDecibels3 = apvts.getRawParameterValue("Peak3 Gain")->load();
-    settings.peakQuality3 = apvts.getRawParameterValue("Peak3 Quality")->load();
-    
-    settings.peakFreq4 = apvts.getRawParameterValue("Peak4 Freq")->load();
-    settings.peakGainInDecibels4 = apvts.getRawParameterValue("Peak4 Gain")->load();
-    settings.peakQuality4 = apvts.getRawParameterValue("Peak4 Quality")->load();
+    blockTimer.finished(buffer.getNumSamples(), getSampleRate());
+}
 
+template <typename FloatType>
+juce::dsp::AudioBlock<FloatType> SimpleEqAudioProcessor::getDetectorBlock (juce::dsp::AudioBlock<FloatType>& block, juce::dsp::AudioBlock<FloatType>& inputBlock)
+{
+    if (parameters.sidechain->load() < 0.5f)
+        return inputBlock;
 
-    return settings;
+    auto* sidechainBus = getBus(true, 1);
 
-};
+    if (sidechainBus == nullptr || ! sidechainBus->isEnabled() || sidechainBus->getNumberOfChannels() == 0)
+        return inputBlock;
 
-void SimpleEqAudioProcessor::updateCoefficients(Coefficients& old, const Coefficients& replacements)
-{
-	*old = *replacements;
-};
+    return block.getSubsetChannelBlock((size_t) getChannelIndexInProcessBlockBuffer(true, 1, 0),
+                                       (size_t) sidechainBus->getNumberOfChannels());
+}
 
-void SimpleEqAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+template <typename FloatType>
+void SimpleEqAudioProcessor::processCascade (juce::dsp::AudioBlock<FloatType>& block, MultichannelCascade<ChainSampleType<FloatType>>& cascade)
 {
-    //get filter coeffiecnts peak filter 1
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq1, chainSettings.peakQuality1, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels1));
-    auto peakCoefficients2 = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq2, chainSettings.peakQuality2, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels2));
-    auto peakCoefficients3 = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq3, chainSettings.peakQuality3, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels3));
-    auto peakCoefficients4 = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq4, chainSettings.peakQuality4, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels4));
+    auto numSamples = block.getNumSamples();
+    auto interval = (size_t) controlIntervalSamples.load(std::memory_order_relaxed);
+    size_t start = 0;
 
+    //with nothing being designed the first pass covers the whole block, so a static
+    //session costs one flag read over processing the block in one go
+    while (start < numSamples)
+    {
+        auto length = numSamples - start;
 
-    //set filter coefficients for peak fileters
-    //*leftChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
-    //*rightChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
-	updateCoefficients(leftChain.get<ChainPositions::Peak1>().coefficients, peakCoefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak1>().coefficients, peakCoefficients);
+        if (interval > 0 && coefficientWorker.isDesignPending())
+            length = juce::jmin(length, interval);
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak2>().coefficients, peakCoefficients2);
-    updateCoefficients(rightChain.get<ChainPositions::Peak2>().coefficients, peakCoefficients2);
+        auto subBlock = block.getSubBlock(start, length);
+        juce::dsp::ProcessContextReplacing<FloatType> context(subBlock);
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak3>().coefficients, peakCoefficients3);
-    updateCoefficients(rightChain.get<ChainPositions::Peak3>().coefficients, peakCoefficients3);
+        if (workerPool.getNumThreads() > 0 && length >= (size_t) minParallelSamples)
+            cascade.process(context, workerPool);
+        else
+            cascade.process(context);
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak4>().coefficients, peakCoefficients4);
-    updateCoefficients(rightChain.get<ChainPositions::Peak4>().coefficients, peakCoefficients4);
+        start += length;
 
+        //the filter state carries straight on, only the coefficients it reads are swapped
+        if (start < numSamples)
+            if (auto* coefficients = coefficientWorker.getNewCoefficients())
+                updateFilters(*coefficients);
+    }
+}
 
+void SimpleEqAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processBuffer(buffer, chain, stateVariableBands, dynamicBands);
+}
 
-};
+void SimpleEqAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processBuffer(buffer, doubleChain, doubleStateVariableBands, doubleDynamicBands);
+}
 
-void SimpleEqAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+//==============================================================================
+bool SimpleEqAudioProcessor::hasEditor() const
 {
-    //get filter coeffiecnts for low cut
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, getSampleRate(), 2 * (chainSettings.lowCutSlope + 1));
+    return true; // (change this to false if you choose to not supply an editor)
+}
 
-    // get left and right low cut filter chains
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+juce::AudioProcessorEditor* SimpleEqAudioProcessor::createEditor()
+{
+    return new SimpleEqAudioProcessorEditor (*this);
+}
 
-    //updating low cut filter chains with coeffiecnts
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-};
+//==============================================================================
+void SimpleEqAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    //binary ValueTree rather than XML, it is smaller and much quicker to parse when a session recalls many instances
+    auto state = apvts.copyState();
+    state.setProperty("version", stateVersion, nullptr);
+    state.setProperty("program", currentProgram.load(), nullptr);
 
-void SimpleEqAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+    juce::MemoryOutputStream stream(destData, false);
+    state.writeToStream(stream);
+}
+
+void SimpleEqAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    //get filter coeffiecnts for high cut
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, getSampleRate(), 2 * (chainSettings.highCutSlope + 1));
+    juce::ValueTree state;
 
-    // get left and right high cut filter chains
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    //states saved as XML, e.g. by hand or by older tools, are accepted as well. They are told apart by
+    //copyXmlToBinary's magic number, readFromData would take them for a tree of some other type
+    if (auto xml = getXmlFromBinary(data, sizeInBytes))
+        state = juce::ValueTree::fromXml(*xml);
+    else
+        state = juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
 
-    //updating high cut filter chains with coeffiecnts
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
-};
+    if (! state.hasType(apvts.state.getType()))
+        return;
 
-void SimpleEqAudioProcessor::updateFilters()
-{
-	auto chainSettings = getChainSettings(apvts);
+    //newer states may hold things this build does not know about, their parameters still load
+    jassert((int) state.getProperty("version", stateVersion) <= stateVersion);
 
-	updateLowCutFilters(chainSettings);
-	updateHighCutFilters(chainSettings);
-	updatePeakFilter(chainSettings);
-};
+    currentProgram = juce::jlimit(0, getNumPrograms() - 1, (int) state.getProperty("program", 0));
 
-juce::AudioProcessorValueTreeState::ParameterLayout
-SimpleEqAudioProcessor::createParameterLayout()
+    state.removeProperty("version", nullptr);
+    state.removeProperty("program", nullptr);
+
+    //the parameter listeners mark the affected bands dirty, the design thread picks them up from the shared cache
+    apvts.replaceState(state);
+}
+
+void SimpleEqAudioProcessor::updateFilters(const CoefficientSet& coefficients)
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20000.f));
+    //the cascades read straight from the published set, so this is only a pointer swap
+    cascadeTailSamples = coefficients.cascade.tailSamples;
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Freq", "Band 1 Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Gain", "Band 1 Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak1 Quality", "Band 1 Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+    if (coefficients.sampleRate > 0.0)
+        cascadeTailSeconds.store(cascadeTailSamples / coefficients.sampleRate);
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Freq", "Band 2 Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Gain", "Band 2 Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak2 Quality", "Band 2 Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+	chain.setCoefficients(coefficients.cascade);
+    doubleChain.setCoefficients(coefficients.cascade);
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Freq", "Band 3 Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Gain", "Band 3 Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak3 Quality", "Band 3 Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+    //the later stages take a band over exactly when the cascade starts fading it out
+    for (int peak = 0; peak < numPeakBands; ++peak)
+    {
+        auto& band = coefficients.bands[(size_t) (Peak1 + peak)];
+
+        stateVariableBands.setEnabled(peak, band.stateVariable);
+        doubleStateVariableBands.setEnabled(peak, band.stateVariable);
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak4 Freq", "Band 4 Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak4 Gain", "Band 4 Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak4 Quality","Band 4 Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+        dynamicBands.setBand(peak, band);
+        doubleDynamicBands.setBand(peak, band);
+    }
+}
 
+void SimpleEqAudioProcessor::parameterChanged(const juce::String& parameterID, float)
+{
+    if (parameterID == "Phase Mode" || parameterID == "Linear Phase Quality")
+    {
+        coefficientWorker.markKernelDirty();
+        triggerAsyncUpdate();
 
-    juce::StringArray stringArray;
-    for (int i = 0; i < 4; i++)
+        //linear phase designs every peak as a biquad, whatever its topology
+        if (parameterID == "Phase Mode")
+            coefficientWorker.markAllBandsDirty();
+    }
+    else if (auto band = ChainParameters::getBandForParameterID(parameterID); band >= 0)
     {
-        juce::String str;
-        str << (12 + i * 12);
-        str << " db/Oct";
-        stringArray.add(str);
+        coefficientWorker.markBandDirty(band);
     }
+}
 
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+bool SimpleEqAudioProcessor::waitForLinearPhaseKernel(int timeoutMs)
+{
+    return ! linearPhaseActive || linearPhase.waitUntilKernelLoaded(timeoutMs);
+}
 
+void SimpleEqAudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
 
+void SimpleEqAudioProcessor::updateLatency()
+{
+    auto chainSettings = parameters.load();
 
+    setLatencySamples(chainSettings.phaseMode == LinearPhase ? linearPhase.getLatencySamples(chainSettings.linearPhaseQuality) : 0);
+}
 
+juce::AudioProcessorValueTreeState::ParameterLayout
+SimpleEqAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    ChainParameters::addToLayout(layout);
 
     return layout;
 };
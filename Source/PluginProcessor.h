@@ -9,35 +9,27 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-enum Slope
-{
-	slope_12,
-	slope_24,
-    slope_36,
-	slope_48
-};
-
-struct ChainSettings 
-{
-	
-	float lowCutFreq{ 0 }, highCutFreq{ 0 };
-    float peakFreq1{ 0 }, peakGainInDecibels1{ 0 }, peakQuality1{ 1.f };
-    float peakFreq2{ 0 }, peakGainInDecibels2{ 0 }, peakQuality2{ 1.f };
-    float peakFreq3{ 0 }, peakGainInDecibels3{ 0 }, peakQuality3{ 1.f };
-    float peakFreq4{ 0 }, peakGainInDecibels4{ 0 }, peakQuality4{ 1.f };
-
-
-    Slope lowCutSlope{ Slope::slope_12 }, highCutSlope{ Slope::slope_12 }; 
-};
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);    
-
+#include "MultichannelCascade.h"
+#include "StateVariableBands.h"
+#include "DynamicBands.h"
+#include "LinearPhaseFilter.h"
+#include "EqParameters.h"
+#include "CoefficientWorker.h"
+#include "PerformanceMonitor.h"
+#include "SpectrumAnalyzer.h"
+
+//runs groups of channels through a single cascade in SIMDRegister lanes,
+//set to 0 to fall back to one scalar cascade per channel
+#ifndef SIMPLEEQ_USE_SIMD
+ #define SIMPLEEQ_USE_SIMD JUCE_USE_SIMD
+#endif
 
 //==============================================================================
 /**
 */
-class SimpleEqAudioProcessor  : public juce::AudioProcessor
+class SimpleEqAudioProcessor  : public juce::AudioProcessor,
+                                private juce::AudioProcessorValueTreeState::Listener,
+                                private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -53,6 +45,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    //the cascade runs natively in either precision, so hosts with a 64-bit engine need no conversion
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -77,64 +73,122 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 	static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    //hit rate and memory use of the coefficient cache shared by every instance
+    CoefficientCache::Stats getCoefficientCacheStats() const { return coefficientWorker.getCacheStats(); }
+
+    //largest main bus the processor accepts, anything from mono up to this is fine
+    static constexpr int maxNumChannels = 128;
+
+    //while new coefficients are on their way the cascade runs in sub-blocks of this many samples,
+    //picking up each set at the next boundary instead of the next host block. 0 never splits
+    void setControlInterval(int numSamples) noexcept  { controlIntervalSamples.store(juce::jmax(0, numSamples)); }
+    static constexpr int defaultControlIntervalSamples = 64;
+
+    //worker threads helping the audio thread with the channels of a wide bus, for offline renders of
+    //large arrays. Takes effect at the next prepareToPlay; 0, the default, keeps everything on one thread
+    void setNumWorkerThreads(int numThreads) noexcept  { numWorkerThreads = juce::jmax(0, numThreads); }
+
+    //offline tools that want coefficient design in step with processing, and timed with it, turn the
+    //design thread off and call designPendingCoefficients() before each block
+    void setDesignOnCallingThread(bool shouldDesignOnCallingThread)  { coefficientWorker.setDesignOnCallingThread(shouldDesignOnCallingThread); }
+    void designPendingCoefficients()  { coefficientWorker.designPending(); }
+
+    //the linear phase kernel reaches the convolution asynchronously, offline renders call this after
+    //prepareToPlay so that their first sample already goes through it. False on timeout
+    bool waitForLinearPhaseKernel(int timeoutMs);
+
+    //narrower buses, or shorter blocks, are not worth handing over to the pool
+    static constexpr int minParallelChannels = 16;
+    static constexpr int minParallelSamples = 32;
+
+    //per block timings of processBlock, switched on from the editor
+    PerformanceMonitor& getPerformanceMonitor() noexcept { return performanceMonitor; }
+
+    //pre and post EQ spectra, only fed while an editor is showing them
+    SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return spectrumAnalyzer; }
+
+    //lock free view of the designed bands for drawing the response curve, message thread only
+    const CoefficientSet* getNewDisplayCoefficients() noexcept { return coefficientWorker.getNewDisplayCoefficients(); }
+    const CoefficientSet& getLastDisplayCoefficients() const noexcept { return coefficientWorker.getLastDisplayCoefficients(); }
+
 	juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
 private:
 
-	using Filter = juce::dsp::IIR::Filter<float>;
-	using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-	using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, Filter,Filter,Filter, CutFilter>;
-	MonoChain leftChain, rightChain;
-
-	enum ChainPositions
-	{
-		LowCut,
-		Peak1,
-        Peak2,
-        Peak3,
-        Peak4,
-		HighCut
-	};
-
-	void updatePeakFilter(const ChainSettings& chainSettings);
-
-	using Coefficients = Filter::CoefficientsPtr;
-	static void updateCoefficients(Coefficients& old, const Coefficients& replacements); 
-
-    template <int Index,typename ChainType, typename CoefficientType>
-	void updateCutFilterLinks(ChainType& chain, const CoefficientType& coefficients)
-	{
-        updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-		chain.template setBypassed<Index>(false);
-	};
-
-    template <typename ChainType, typename CoefficientType>
-    void updateCutFilter(ChainType& cutChain, const CoefficientType& cutCoefficients, const Slope& cutSlope)
-    {
-
-        //bypassing all links in the  low cut chain.
-        cutChain.template setBypassed<0>(true);
-        cutChain.template setBypassed<1>(true);
-        cutChain.template setBypassed<2>(true);
-        cutChain.template setBypassed<3>(true);
-
-        switch (cutSlope)
-
-        {
-        case slope_48:
-			updateCutFilterLinks<3>(cutChain, cutCoefficients);
-        case slope_36:
-			updateCutFilterLinks<2>(cutChain, cutCoefficients);
-        case slope_24:
-			updateCutFilterLinks<1>(cutChain, cutCoefficients);
-        case slope_12:
-			updateCutFilterLinks<0>(cutChain, cutCoefficients);
-
-        }
-    };
-
-	void updateFilters();
-	void updateLowCutFilters(const ChainSettings& chainSettings);
-	void updateHighCutFilters(const ChainSettings& chainSettings);
+   #if SIMPLEEQ_USE_SIMD
+    template <typename FloatType>
+    using ChainSampleType = juce::dsp::SIMDRegister<FloatType>;
+   #else
+    template <typename FloatType>
+    using ChainSampleType = FloatType;
+   #endif
+
+    //all channels of the main bus, sharing one set of coefficients. Only the one
+    //matching the processing precision is prepared, the other has no channels
+    MultichannelCascade<ChainSampleType<float>> chain;
+    MultichannelCascade<ChainSampleType<double>> doubleChain;
+
+    //peaks switched to the state variable topology, run after the cascade in minimum phase mode
+    StateVariableBands<float> stateVariableBands;
+    StateVariableBands<double> doubleStateVariableBands;
+
+    //peaks switched to dynamic, their detectors run before the cascade and the bands after it
+    DynamicBands<float> dynamicBands;
+    DynamicBands<double> doubleDynamicBands;
+
+    template <typename FloatType>
+    void processBuffer(juce::AudioBuffer<FloatType>& buffer, MultichannelCascade<ChainSampleType<FloatType>>& cascade,
+                       StateVariableBands<FloatType>& stateVariable, DynamicBands<FloatType>& dynamic);
+
+    //the sidechain bus when it is switched on and connected, otherwise the main input
+    template <typename FloatType>
+    juce::dsp::AudioBlock<FloatType> getDetectorBlock(juce::dsp::AudioBlock<FloatType>& block, juce::dsp::AudioBlock<FloatType>& inputBlock);
+
+    template <typename FloatType>
+    void processCascade(juce::dsp::AudioBlock<FloatType>& block, MultichannelCascade<ChainSampleType<FloatType>>& cascade);
+
+    std::atomic<int> controlIntervalSamples{ defaultControlIntervalSamples };
+
+    ChannelWorkerPool workerPool;
+    int numWorkerThreads = 0;
+
+    //used instead of the cascade in linear phase mode, its kernel is designed by the worker
+    LinearPhaseFilter linearPhase;
+
+    //resolved once, the audio thread only does atomic loads through these
+    ChainParameters parameters{ apvts };
+    bool linearPhaseActive = false;
+
+    //output gain across a phase mode switch, which happens once it has faded to silence
+    juce::SmoothedValue<float> phaseSwitchGain{ 1.0f };
+    static constexpr double phaseSwitchFadeSeconds = 0.01;
+
+    //once the input has been silent for longer than the tail, filtering is skipped entirely
+    juce::int64 silentSamples = 0;
+    bool suspended = false;
+    double cascadeTailSamples = 0.0;
+    std::atomic<double> cascadeTailSeconds{ 0.0 };
+
+    //about -160 dBFS, treated as digital silence in either precision
+    static constexpr float silenceThreshold = 1.0e-8f;
+
+    CoefficientWorker coefficientWorker{ apvts, linearPhase };
+
+    PerformanceMonitor performanceMonitor;
+    SpectrumAnalyzer spectrumAnalyzer;
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    //latency follows the phase mode and kernel length, hosts expect to hear about it on the message thread
+    void handleAsyncUpdate() override;
+    void updateLatency();
+
+	void updateFilters(const CoefficientSet& coefficients);
+
+    std::atomic<int> currentProgram{ 0 };
+
+    //bumped whenever the saved layout changes, setStateInformation migrates anything older
+    static constexpr int stateVersion = 1;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEqAudioProcessor)
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    Presets.cpp
+
+  ==============================================================================
+*/
+
+#include "Presets.h"
+
+//peaks fill the bands from the lowest, the rest stay flat
+static ChainSettings makeSettings(float lowCutFreq, Slope lowCutSlope, float highCutFreq, Slope highCutSlope,
+                                  std::initializer_list<PeakSettings> peaks)
+{
+    ChainSettings settings;
+
+    settings.lowCutFreq = lowCutFreq;
+    settings.lowCutSlope = lowCutSlope;
+    settings.highCutFreq = highCutFreq;
+    settings.highCutSlope = highCutSlope;
+
+    size_t index = 0;
+
+    for (auto& peak : peaks)
+        if (index < settings.peaks.size())
+            settings.peaks[index++] = peak;
+
+    return settings;
+}
+
+static void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float value)
+{
+    if (auto* parameter = apvts.getParameter(id))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+const std::vector<Preset>& getFactoryPresets()
+{
+    static const std::vector<Preset> presets
+    {
+        { "Default",         makeSettings(20.f,  slope_12, 20000.f, slope_12, {}) },
+        { "Low End Cleanup", makeSettings(40.f,  slope_24, 20000.f, slope_12, { { 250.f, -3.f, 1.f } }) },
+        { "Vocal Presence",  makeSettings(90.f,  slope_24, 18000.f, slope_12, { { 300.f, -2.f, 1.f }, { 3000.f, 3.f, 1.5f }, { 7000.f, -2.f, 4.f }, { 12000.f, 2.f, 0.7f } }) },
+        { "Kick Tighten",    makeSettings(30.f,  slope_48, 20000.f, slope_12, { { 60.f, 3.f, 1.5f }, { 350.f, -5.f, 2.f }, { 4000.f, 3.f, 2.f } }) },
+        { "De-mud",          makeSettings(20.f,  slope_12, 20000.f, slope_12, { { 200.f, -3.f, 1.f }, { 450.f, -4.f, 1.5f } }) },
+        { "Air",             makeSettings(20.f,  slope_12, 20000.f, slope_12, { { 10000.f, 3.f, 0.5f }, { 16000.f, 2.f, 0.7f } }) },
+        { "Bright Master",   makeSettings(25.f,  slope_36, 20000.f, slope_12, { { 100.f, 1.f, 0.7f }, { 2500.f, 1.f, 0.5f }, { 12000.f, 2.f, 0.5f } }) },
+        { "Telephone",       makeSettings(400.f, slope_48, 3400.f,  slope_48, { { 1500.f, 4.f, 1.f } }) }
+    };
+
+    return presets;
+}
+
+void setChainSettings(juce::AudioProcessorValueTreeState& apvts, const ChainSettings& settings)
+{
+    setParameter(apvts, "LowCut Freq", settings.lowCutFreq);
+    setParameter(apvts, "LowCut Slope", (float) settings.lowCutSlope);
+    setParameter(apvts, "HighCut Freq", settings.highCutFreq);
+    setParameter(apvts, "HighCut Slope", (float) settings.highCutSlope);
+
+    for (size_t peak = 0; peak < settings.peaks.size(); ++peak)
+    {
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Freq"), settings.peaks[peak].freq);
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Gain"), settings.peaks[peak].gainInDecibels);
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Quality"), settings.peaks[peak].quality);
+
+        //written even when a preset leaves them at their defaults, so loading one never keeps the previous topology or dynamics
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Topology"), settings.peaks[peak].stateVariable ? 1.f : 0.f);
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Dynamic"), settings.peaks[peak].dynamic ? 1.f : 0.f);
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Threshold"), settings.peaks[peak].thresholdInDecibels);
+        setParameter(apvts, ChainParameters::getPeakParameterID((int) peak, "Range"), settings.peaks[peak].rangeInDecibels);
+    }
+}
+
+ChainSettings snapToParameters(juce::AudioProcessorValueTreeState& apvts, ChainSettings settings)
+{
+    auto snap = [&apvts](const juce::String& id, float& value) { value = apvts.getParameterRange(id).snapToLegalValue(value); };
+
+    snap("LowCut Freq", settings.lowCutFreq);
+    snap("HighCut Freq", settings.highCutFreq);
+
+    for (size_t peak = 0; peak < settings.peaks.size(); ++peak)
+    {
+        snap(ChainParameters::getPeakParameterID((int) peak, "Freq"), settings.peaks[peak].freq);
+        snap(ChainParameters::getPeakParameterID((int) peak, "Gain"), settings.peaks[peak].gainInDecibels);
+        snap(ChainParameters::getPeakParameterID((int) peak, "Quality"), settings.peaks[peak].quality);
+        snap(ChainParameters::getPeakParameterID((int) peak, "Threshold"), settings.peaks[peak].thresholdInDecibels);
+        snap(ChainParameters::getPeakParameterID((int) peak, "Range"), settings.peaks[peak].rangeInDecibels);
+    }
+
+    return settings;
+}
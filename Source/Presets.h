@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    Presets.h
+    Factory preset bank.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+struct Preset
+{
+    juce::String name;
+    ChainSettings settings;
+};
+
+//the first entry is the flat default; phase mode and kernel length are not part of a preset
+const std::vector<Preset>& getFactoryPresets();
+
+//writes the band parameters of a preset to the tree, topology and dynamics included, notifying the host
+void setChainSettings(juce::AudioProcessorValueTreeState& apvts, const ChainSettings& settings);
+
+//rounds every value the way the parameters would, so presets design exactly what the parameters will hold
+ChainSettings snapToParameters(juce::AudioProcessorValueTreeState& apvts, ChainSettings settings);
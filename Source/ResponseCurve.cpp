@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+
+void ResponseCurve::setFrequencies(int newNumPoints, float minimumFrequency, float maximumFrequency, double sampleRate)
+{
+    numPoints = juce::jmax(0, newNumPoints);
+    currentSampleRate = sampleRate;
+
+    cosW.resize((size_t) numPoints);
+    cos2W.resize((size_t) numPoints);
+    numerator.resize((size_t) numPoints);
+    denominator.resize((size_t) numPoints);
+    scratch.resize((size_t) numPoints);
+    totalDecibels.assign((size_t) numPoints, 0.f);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        //points are spread logarithmically, the same way the display lays out frequency
+        auto proportion = numPoints > 1 ? (double) i / (double) (numPoints - 1) : 0.0;
+        auto frequency = minimumFrequency * std::pow((double) maximumFrequency / minimumFrequency, proportion);
+        auto w = juce::MathConstants<double>::twoPi * juce::jmin(frequency, 0.5 * sampleRate) / sampleRate;
+
+        cosW[(size_t) i] = std::cos(w);
+        cos2W[(size_t) i] = std::cos(2.0 * w);
+    }
+
+    for (auto& decibels : bandDecibels)
+        decibels.assign((size_t) numPoints, 0.0);
+
+    cachedVersions.fill(invalidVersion);
+}
+
+bool ResponseCurve::update(const std::array<BandCoefficients, NumChainPositions>& bands)
+{
+    if (numPoints == 0 || currentSampleRate <= 0.0)
+        return false;
+
+    bool anyChanged = false;
+
+    for (size_t band = 0; band < bands.size(); ++band)
+    {
+        if (bands[band].version == cachedVersions[band])
+            continue;
+
+        computeBand(bands[band], bandDecibels[band]);
+        cachedVersions[band] = bands[band].version;
+        anyChanged = true;
+    }
+
+    if (! anyChanged)
+        return false;
+
+    //cascaded bands multiply, so their dB curves simply add
+    std::fill(scratch.begin(), scratch.end(), 0.0);
+
+    for (auto& decibels : bandDecibels)
+        juce::FloatVectorOperations::add(scratch.data(), decibels.data(), numPoints);
+
+    for (size_t i = 0; i < (size_t) numPoints; ++i)
+        totalDecibels[i] = (float) scratch[i];
+
+    return true;
+}
+
+void ResponseCurve::computeBand(const BandCoefficients& band, std::vector<double>& decibels)
+{
+    if (band.bypassed)
+    {
+        std::fill(decibels.begin(), decibels.end(), 0.0);
+        return;
+    }
+
+    juce::FloatVectorOperations::fill(numerator.data(), 1.0, numPoints);
+    juce::FloatVectorOperations::fill(denominator.data(), 1.0, numPoints);
+
+    for (int section = 0; section < band.numSections; ++section)
+    {
+        auto& biquad = band.sections[(size_t) section];
+
+        multiplyBySquaredMagnitude(numerator, biquad.b0, biquad.b1, biquad.b2);
+        multiplyBySquaredMagnitude(denominator, 1.0, biquad.a1, biquad.a2);
+    }
+
+    //10 log10 of a power ratio, floored so that deep cuts stay finite
+    for (size_t i = 0; i < (size_t) numPoints; ++i)
+        decibels[i] = 10.0 * std::log10(juce::jmax(1.0e-20, numerator[i] / denominator[i]));
+}
+
+void ResponseCurve::multiplyBySquaredMagnitude(std::vector<double>& result, double x0, double x1, double x2)
+{
+    auto c0 = x0 * x0 + x1 * x1 + x2 * x2;
+    auto c1 = 2.0 * (x0 * x1 + x1 * x2);
+    auto c2 = 2.0 * x0 * x2;
+
+    juce::FloatVectorOperations::fill(scratch.data(), c0, numPoints);
+    juce::FloatVectorOperations::addWithMultiply(scratch.data(), cosW.data(), c1, numPoints);
+    juce::FloatVectorOperations::addWithMultiply(scratch.data(), cos2W.data(), c2, numPoints);
+    juce::FloatVectorOperations::multiply(result.data(), scratch.data(), numPoints);
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.h
+    Combined magnitude response of the bands at a fixed set of frequencies.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+/**
+    Keeps each band's magnitude in dB at every frequency point and only
+    recomputes a band when its version changes, so dragging one node costs a
+    single band. Biquad magnitudes are evaluated from the expanded form
+    |B|^2 = c0 + c1 cos(w) + c2 cos(2w), which turns every section into a few
+    FloatVectorOperations across all points; bands are then summed in dB.
+*/
+class ResponseCurve
+{
+public:
+    //throws away every cached band when the points or sample rate change
+    void setFrequencies(int numPoints, float minimumFrequency, float maximumFrequency, double sampleRate);
+
+    //returns true if any band had to be recomputed
+    bool update(const std::array<BandCoefficients, NumChainPositions>& bands);
+
+    const std::vector<float>& getDecibels() const noexcept  { return totalDecibels; }
+    int getNumPoints() const noexcept                       { return numPoints; }
+
+private:
+    void computeBand(const BandCoefficients& band, std::vector<double>& decibels);
+
+    //|b0 + b1 z^-1 + b2 z^-2|^2 at every point, multiplied into result
+    void multiplyBySquaredMagnitude(std::vector<double>& result, double x0, double x1, double x2);
+
+    int numPoints = 0;
+    double currentSampleRate = 0.0;
+
+    std::vector<double> cosW, cos2W;
+    std::vector<double> numerator, denominator, scratch;
+
+    static constexpr juce::uint32 invalidVersion = 0xffffffff;
+    std::array<juce::uint32, NumChainPositions> cachedVersions;
+    std::array<std::vector<double>, NumChainPositions> bandDecibels;
+
+    std::vector<float> totalDecibels;
+};
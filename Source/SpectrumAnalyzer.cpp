@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+{
+    for (auto& decibels : smoothedFrame.decibels)
+        std::fill(decibels.begin(), decibels.end(), minimumDecibels);
+
+    analysisThread->addTimeSliceClient(this, idlePollIntervalMs);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    analysisThread->removeTimeSliceClient(this);
+}
+
+void SpectrumAnalyzer::push(Tap tap, const juce::dsp::AudioBlock<const float>& block) noexcept
+{
+    if (! isActive() || block.getNumChannels() == 0)
+        return;
+
+    auto& state = taps[(size_t) tap];
+    auto numSamples = (int) block.getNumSamples();
+    auto numChannels = block.getNumChannels();
+    auto channelGain = 1.f / (float) numChannels;
+
+    //whatever does not fit is dropped, the analyzer just misses a few samples
+    const auto scope = state.fifo.write(numSamples);
+
+    auto mixInto = [&](int start, int size, int offset)
+    {
+        if (size <= 0)
+            return;
+
+        auto* destination = state.fifoBuffer.data() + start;
+        juce::FloatVectorOperations::multiply(destination, block.getChannelPointer(0) + offset, channelGain, size);
+
+        for (size_t channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, block.getChannelPointer(channel) + offset, channelGain, size);
+    };
+
+    mixInto(scope.startIndex1, scope.blockSize1, 0);
+    mixInto(scope.startIndex2, scope.blockSize2, scope.blockSize1);
+}
+
+void SpectrumAnalyzer::push(Tap tap, const juce::dsp::AudioBlock<const double>& block) noexcept
+{
+    if (! isActive() || block.getNumChannels() == 0)
+        return;
+
+    auto& state = taps[(size_t) tap];
+    auto numChannels = block.getNumChannels();
+    auto channelGain = 1.0 / (double) numChannels;
+
+    const auto scope = state.fifo.write((int) block.getNumSamples());
+
+    //the analysis runs in float either way, so the mix is rounded as it goes in
+    auto mixInto = [&](int start, int size, int offset)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            double sum = 0.0;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                sum += block.getSample((int) channel, offset + i);
+
+            state.fifoBuffer[(size_t) (start + i)] = (float) (sum * channelGain);
+        }
+    };
+
+    mixInto(scope.startIndex1, scope.blockSize1, 0);
+    mixInto(scope.startIndex2, scope.blockSize2, scope.blockSize1);
+}
+
+int SpectrumAnalyzer::useTimeSlice()
+{
+    if (! isActive())
+        return idlePollIntervalMs;
+
+    auto newSamples = 0;
+
+    for (auto& state : taps)
+        newSamples = juce::jmax(newSamples, drain(state));
+
+    samplesSinceFrame += newSamples;
+
+    if (samplesSinceFrame < hopSize)
+        return framePollIntervalMs;
+
+    samplesSinceFrame = 0;
+
+    for (int tap = 0; tap < NumTaps; ++tap)
+        analyse(taps[(size_t) tap], smoothedFrame.decibels[(size_t) tap]);
+
+    smoothedFrame.sampleRate = currentSampleRate.load();
+
+    frames.getWriteBuffer() = smoothedFrame;
+    frames.publish();
+
+    return framePollIntervalMs;
+}
+
+int SpectrumAnalyzer::drain(TapState& state)
+{
+    const auto scope = state.fifo.read(state.fifo.getNumReady());
+
+    auto copyToHistory = [&state](int start, int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            state.history[(size_t) state.historyPosition] = state.fifoBuffer[(size_t) (start + i)];
+            state.historyPosition = (state.historyPosition + 1) % fftSize;
+        }
+    };
+
+    copyToHistory(scope.startIndex1, scope.blockSize1);
+    copyToHistory(scope.startIndex2, scope.blockSize2);
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+void SpectrumAnalyzer::analyse(TapState& state, std::array<float, numBins>& smoothed)
+{
+    //unwrap the history so the oldest sample comes first
+    auto oldest = (size_t) state.historyPosition;
+    std::copy(state.history.begin() + (long) oldest, state.history.end(), fftData.begin());
+    std::copy(state.history.begin(), state.history.begin() + (long) oldest, fftData.begin() + (long) (fftSize - oldest));
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.f);
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    //a full scale sine reads 0 dB, the hann window halves the amplitude
+    auto scale = 4.f / (float) fftSize;
+
+    for (size_t bin = 0; bin < (size_t) numBins; ++bin)
+    {
+        auto decibels = juce::Decibels::gainToDecibels(fftData[bin] * scale, minimumDecibels);
+        auto& level = smoothed[bin];
+
+        level = decibels > level ? decibels : level * releaseCoefficient + decibels * (1.f - releaseCoefficient);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+    Pre and post EQ spectra, analysed off the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+/**
+    The audio thread pushes a mono mix of the input and output into two
+    preallocated lock-free FIFOs, but only while at least one editor has
+    registered itself with addUser(). A TimeSliceThread shared by every instance
+    drains the FIFOs, runs the windowed FFTs and publishes smoothed spectra
+    through a TripleBuffer, which the editor picks up on the message thread.
+*/
+class SpectrumAnalyzer : private juce::TimeSliceClient
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    enum Tap
+    {
+        Pre,
+        Post,
+        NumTaps
+    };
+
+    struct Frame
+    {
+        std::array<std::array<float, numBins>, NumTaps> decibels;
+        double sampleRate = 0.0;
+    };
+
+    static constexpr float minimumDecibels = -100.f;
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    void prepare(double sampleRate) noexcept   { currentSampleRate.store(sampleRate); }
+
+    //editors register while they are showing, nothing is pushed or analysed without one
+    void addUser() noexcept                     { ++numUsers; }
+    void removeUser() noexcept                  { --numUsers; }
+    bool isActive() const noexcept              { return numUsers.load(std::memory_order_relaxed) > 0; }
+
+    //audio thread
+    void push(Tap tap, const juce::dsp::AudioBlock<const float>& block) noexcept;
+    void push(Tap tap, const juce::dsp::AudioBlock<const double>& block) noexcept;
+
+    //message thread, returns nullptr when no new frame was published since the last call
+    const Frame* getNewFrame() noexcept         { return frames.acquireLatest(); }
+
+private:
+    struct AnalysisThread : public juce::TimeSliceThread
+    {
+        AnalysisThread() : juce::TimeSliceThread("SimpleEq spectrum analyzer") { startThread(); }
+        ~AnalysisThread() override { stopThread(1000); }
+    };
+
+    struct TapState
+    {
+        juce::AbstractFifo fifo{ fifoSize };
+        std::vector<float> fifoBuffer = std::vector<float>((size_t) fifoSize);
+
+        //the last fftSize samples, written circularly
+        std::vector<float> history = std::vector<float>((size_t) fftSize);
+        int historyPosition = 0;
+    };
+
+    int useTimeSlice() override;
+    int drain(TapState& state);
+    void analyse(TapState& state, std::array<float, numBins>& smoothed);
+
+    static constexpr int fifoSize = 1 << 15;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int framePollIntervalMs = 10;
+    static constexpr int idlePollIntervalMs = 100;
+
+    //how much of the previous frame is kept when the level falls
+    static constexpr float releaseCoefficient = 0.8f;
+
+    std::atomic<int> numUsers{ 0 };
+    std::atomic<double> currentSampleRate{ 0.0 };
+
+    std::array<TapState, NumTaps> taps;
+    int samplesSinceFrame = 0;
+
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> fftData = std::vector<float>((size_t) fftSize * 2);
+    Frame smoothedFrame;
+
+    TripleBuffer<Frame> frames;
+
+    juce::SharedResourcePointer<AnalysisThread> analysisThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
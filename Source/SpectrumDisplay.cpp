@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+#include "PluginProcessor.h"
+
+SpectrumDisplay::SpectrumDisplay(SimpleEqAudioProcessor& processorToUse)
+    : processor(processorToUse), analyzer(processorToUse.getSpectrumAnalyzer())
+{
+    setOpaque(true);
+    startTimerHz(maximumFramesPerSecond);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    if (registered)
+        analyzer.removeUser();
+}
+
+void SpectrumDisplay::visibilityChanged()
+{
+    updateRegistration();
+}
+
+void SpectrumDisplay::parentHierarchyChanged()
+{
+    updateRegistration();
+}
+
+void SpectrumDisplay::updateRegistration()
+{
+    //a hidden display costs neither the audio thread nor the analysis thread anything
+    auto shouldRegister = isShowing();
+
+    if (shouldRegister == registered)
+        return;
+
+    registered = shouldRegister;
+
+    if (registered)
+        analyzer.addUser();
+    else
+        analyzer.removeUser();
+}
+
+void SpectrumDisplay::timerCallback()
+{
+    //minimising the editor's window does not count as a visibility change
+    updateRegistration();
+
+    if (! registered)
+        return;
+
+    if (auto* coefficients = processor.getNewDisplayCoefficients())
+        updateResponse(*coefficients);
+
+    if (auto* frame = analyzer.getNewFrame())
+    {
+        rebuildPaths(*frame);
+        repaint();
+    }
+}
+
+void SpectrumDisplay::updateResponse(const CoefficientSet& coefficients)
+{
+    if (coefficients.sampleRate != responseSampleRate)
+    {
+        responseSampleRate = coefficients.sampleRate;
+        responseCurve.setFrequencies(getWidth(), minimumFrequency, maximumFrequency, responseSampleRate);
+    }
+
+    //only the bands whose version moved are recomputed
+    if (responseCurve.update(coefficients.bands))
+    {
+        rebuildResponsePath();
+        repaint();
+    }
+}
+
+void SpectrumDisplay::rebuildResponsePath()
+{
+    auto& decibels = responseCurve.getDecibels();
+    auto numPoints = responseCurve.getNumPoints();
+
+    responsePath.clear();
+    responsePath.preallocateSpace(3 * numPoints);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto x = numPoints > 1 ? (float) getWidth() * (float) i / (float) (numPoints - 1) : 0.f;
+        auto y = juce::jmap(juce::jlimit(-responseRangeDecibels, responseRangeDecibels, decibels[(size_t) i]),
+                            -responseRangeDecibels, responseRangeDecibels, (float) getHeight(), 0.f);
+
+        if (i == 0)
+            responsePath.startNewSubPath(x, y);
+        else
+            responsePath.lineTo(x, y);
+    }
+}
+
+void SpectrumDisplay::resized()
+{
+    rebuildGrid();
+    prePath.clear();
+    postPath.clear();
+
+    //one response point per pixel column
+    responseSampleRate = processor.getLastDisplayCoefficients().sampleRate;
+    responseCurve.setFrequencies(getWidth(), minimumFrequency, maximumFrequency, responseSampleRate);
+    updateResponse(processor.getLastDisplayCoefficients());
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    g.setColour(juce::Colours::dimgrey.withAlpha(0.5f));
+    g.strokePath(grid, juce::PathStrokeType(1.f));
+
+    g.setColour(juce::Colours::skyblue.withAlpha(0.25f));
+    g.fillPath(prePath);
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(postPath, juce::PathStrokeType(1.5f));
+
+    g.setColour(juce::Colours::white);
+    g.strokePath(responsePath, juce::PathStrokeType(2.f));
+}
+
+float SpectrumDisplay::frequencyToX(float frequency) const noexcept
+{
+    return (float) getWidth() * std::log(frequency / minimumFrequency) / std::log(maximumFrequency / minimumFrequency);
+}
+
+float SpectrumDisplay::decibelsToY(float decibels) const noexcept
+{
+    return juce::jmap(decibels, minimumDecibels, maximumDecibels, (float) getHeight(), 0.f);
+}
+
+void SpectrumDisplay::rebuildGrid()
+{
+    grid.clear();
+
+    for (auto frequency : { 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f })
+    {
+        auto x = frequencyToX(frequency);
+        grid.addLineSegment({ x, 0.f, x, (float) getHeight() }, 1.f);
+    }
+
+    for (auto decibels = -84.f; decibels <= maximumDecibels; decibels += 12.f)
+    {
+        auto y = decibelsToY(decibels);
+        grid.addLineSegment({ 0.f, y, (float) getWidth(), y }, 1.f);
+    }
+}
+
+void SpectrumDisplay::rebuildPaths(const SpectrumAnalyzer::Frame& frame)
+{
+    auto width = getWidth();
+
+    if (width <= 0 || frame.sampleRate <= 0.0)
+        return;
+
+    auto binWidth = (float) (frame.sampleRate / SpectrumAnalyzer::fftSize);
+    auto bottom = (float) getHeight();
+
+    //one point per pixel column, taking the loudest bin that falls into it
+    auto addSpectrum = [&](juce::Path& path, const std::array<float, SpectrumAnalyzer::numBins>& decibels, bool closed)
+    {
+        path.clear();
+        path.preallocateSpace(3 * (width + 4));
+
+        for (int x = 0; x < width; ++x)
+        {
+            auto lowFrequency = minimumFrequency * std::pow(maximumFrequency / minimumFrequency, (float) x / (float) width);
+            auto highFrequency = minimumFrequency * std::pow(maximumFrequency / minimumFrequency, (float) (x + 1) / (float) width);
+
+            auto firstBin = juce::jlimit(0, SpectrumAnalyzer::numBins - 1, (int) (lowFrequency / binWidth));
+            auto lastBin = juce::jlimit(firstBin, SpectrumAnalyzer::numBins - 1, (int) (highFrequency / binWidth));
+
+            auto level = *std::max_element(decibels.begin() + firstBin, decibels.begin() + lastBin + 1);
+            auto y = juce::jmin(bottom, decibelsToY(level));
+
+            if (x == 0)
+            {
+                if (closed)
+                {
+                    path.startNewSubPath(0.f, bottom);
+                    path.lineTo(0.f, y);
+                }
+                else
+                {
+                    path.startNewSubPath(0.f, y);
+                }
+            }
+            else
+            {
+                path.lineTo((float) x, y);
+            }
+        }
+
+        if (closed)
+        {
+            path.lineTo((float) width, bottom);
+            path.closeSubPath();
+        }
+    };
+
+    addSpectrum(prePath, frame.decibels[SpectrumAnalyzer::Pre], true);
+    addSpectrum(postPath, frame.decibels[SpectrumAnalyzer::Post], false);
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.h
+    Draws the analyzer's pre and post EQ spectra under the EQ response curve.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyzer.h"
+#include "ResponseCurve.h"
+
+class SimpleEqAudioProcessor;
+
+/**
+    Registers with the SpectrumAnalyzer while it is showing, polls it and the
+    processor's display coefficients at a capped frame rate, and only rebuilds
+    a cached path when its data has changed, so paint() does nothing but stroke
+    and fill them.
+*/
+class SpectrumDisplay : public juce::Component,
+                        private juce::Timer
+{
+public:
+    explicit SpectrumDisplay(SimpleEqAudioProcessor& processorToUse);
+    ~SpectrumDisplay() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
+    static constexpr float minimumFrequency = 20.f, maximumFrequency = 20000.f;
+    static constexpr float minimumDecibels = -90.f, maximumDecibels = 12.f;
+
+    //the response curve gets its own scale, matching the range of the gain parameters
+    static constexpr float responseRangeDecibels = 24.f;
+
+private:
+    void timerCallback() override;
+    void updateRegistration();
+    void rebuildPaths(const SpectrumAnalyzer::Frame& frame);
+    void rebuildGrid();
+    void updateResponse(const CoefficientSet& coefficients);
+    void rebuildResponsePath();
+
+    float frequencyToX(float frequency) const noexcept;
+    float decibelsToY(float decibels) const noexcept;
+
+    SimpleEqAudioProcessor& processor;
+    SpectrumAnalyzer& analyzer;
+    bool registered = false;
+
+    ResponseCurve responseCurve;
+    double responseSampleRate = 0.0;
+
+    juce::Path prePath, postPath, responsePath, grid;
+
+    static constexpr int maximumFramesPerSecond = 60;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
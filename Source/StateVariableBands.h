@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    StateVariableBands.h
+    Peak bands as topology preserving state variable filters, modulated every
+    sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCoefficients.h"
+
+/**
+    Alternative topology for the peak bands, run after the cascade for the bands
+    switched to it. Each band is Simper's trapezoidal SVF bell, which has the
+    same response as the RBJ peak filter the biquads use but stays well behaved
+    while its coefficients move.
+
+    Frequency (as the prewarped g), amplitude and Q are smoothed multiplicatively
+    on every sample, so a step costs a few multiplies and two divides with no tan
+    and no redesign. Automation neither zippers nor waits for the design thread.
+
+    A band switching in starts from unity gain and one switching out returns to
+    it before it stops, while the cascade crossfades the biquad the other way.
+*/
+template <typename FloatType>
+class StateVariableBands
+{
+public:
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        numChannels = (size_t) spec.numChannels;
+
+        for (auto& band : bands)
+        {
+            band.ic1.assign(numChannels, FloatType (0));
+            band.ic2.assign(numChannels, FloatType (0));
+
+            band.g.reset(sampleRate, smoothingSeconds);
+            band.amplitude.reset(sampleRate, smoothingSeconds);
+            band.quality.reset(sampleRate, smoothingSeconds);
+        }
+
+        for (auto* coefficients : { &a1, &a2, &a3, &m1 })
+            coefficients->assign((size_t) spec.maximumBlockSize, FloatType (0));
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& band : bands)
+        {
+            std::fill(band.ic1.begin(), band.ic1.end(), FloatType (0));
+            std::fill(band.ic2.begin(), band.ic2.end(), FloatType (0));
+
+            //whatever was ramping lands on its target
+            band.g.setCurrentAndTargetValue(band.g.getTargetValue());
+            band.amplitude.setCurrentAndTargetValue(band.amplitude.getTargetValue());
+            band.quality.setCurrentAndTargetValue(band.quality.getTargetValue());
+
+            band.running = band.enabled;
+        }
+    }
+
+    //called with the published coefficients, so the switch lines up with the cascade's crossfade
+    void setEnabled(int peak, bool shouldBeEnabled) noexcept
+    {
+        auto& band = bands[(size_t) peak];
+
+        if (band.enabled == shouldBeEnabled)
+            return;
+
+        band.enabled = shouldBeEnabled;
+
+        if (! shouldBeEnabled)
+        {
+            band.amplitude.setTargetValue(FloatType (1));
+            return;
+        }
+
+        //the next setTargets places it, from where it ramps up from unity
+        if (! band.running)
+        {
+            band.amplitude.setCurrentAndTargetValue(FloatType (1));
+            band.entering = true;
+        }
+
+        band.running = true;
+    }
+
+    //audio thread, once per block for every peak, straight from the parameters
+    void setTargets(int peak, float freq, float gainInDecibels, float quality) noexcept
+    {
+        auto& band = bands[(size_t) peak];
+
+        if (! band.enabled)
+            return;
+
+        auto prewarped = std::tan(juce::MathConstants<double>::pi * juce::jmin((double) freq, 0.49 * sampleRate) / sampleRate);
+        auto g = (FloatType) prewarped;
+        auto q = (FloatType) quality;
+
+        if (band.entering)
+        {
+            band.g.setCurrentAndTargetValue(g);
+            band.quality.setCurrentAndTargetValue(q);
+            band.entering = false;
+        }
+        else
+        {
+            band.g.setTargetValue(g);
+            band.quality.setTargetValue(q);
+        }
+
+        //A = 10^(dB / 40), as in the RBJ peak filter
+        band.amplitude.setTargetValue((FloatType) juce::Decibels::decibelsToGain(gainInDecibels * 0.5f));
+    }
+
+    //false when no band uses this topology, the stage then costs nothing
+    bool isActive() const noexcept
+    {
+        return std::any_of(bands.begin(), bands.end(), [](const Band& band) { return band.running; });
+    }
+
+    FloatType getStateMagnitude() const noexcept
+    {
+        FloatType peak (0);
+
+        for (auto& band : bands)
+            if (band.running)
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    peak = juce::jmax(peak, std::abs(band.ic1[channel]), std::abs(band.ic2[channel]));
+
+        return peak;
+    }
+
+    void process(juce::dsp::AudioBlock<FloatType>& block) noexcept
+    {
+        auto numSamples = block.getNumSamples();
+        auto channelsToProcess = juce::jmin(block.getNumChannels(), numChannels);
+
+        jassert(numSamples <= a1.size());
+
+        for (auto& band : bands)
+        {
+            if (! band.running)
+                continue;
+
+            //coefficients are worked out once per sample for all channels, or once per block when settled
+            auto smoothing = band.g.isSmoothing() || band.amplitude.isSmoothing() || band.quality.isSmoothing();
+            size_t stride = smoothing ? 1 : 0;
+
+            if (smoothing)
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                    computeCoefficients(band.g.getNextValue(), band.amplitude.getNextValue(), band.quality.getNextValue(), i);
+            }
+            else
+            {
+                computeCoefficients(band.g.getCurrentValue(), band.amplitude.getCurrentValue(), band.quality.getCurrentValue(), 0);
+            }
+
+            for (size_t channel = 0; channel < channelsToProcess; ++channel)
+                processChannel(band, channel, block.getChannelPointer(channel), numSamples, stride);
+
+            //a band switched out stops once it is back at unity
+            if (! band.enabled && ! band.amplitude.isSmoothing())
+            {
+                band.running = false;
+                std::fill(band.ic1.begin(), band.ic1.end(), FloatType (0));
+                std::fill(band.ic2.begin(), band.ic2.end(), FloatType (0));
+            }
+        }
+    }
+
+private:
+    using Smoother = juce::SmoothedValue<FloatType, juce::ValueSmoothingTypes::Multiplicative>;
+
+    struct Band
+    {
+        Smoother g, amplitude, quality;
+        std::vector<FloatType> ic1, ic2;
+        bool enabled = false, running = false, entering = false;
+    };
+
+    void computeCoefficients(FloatType g, FloatType amplitude, FloatType quality, size_t index) noexcept
+    {
+        auto k = FloatType (1) / (quality * amplitude);
+
+        a1[index] = FloatType (1) / (FloatType (1) + g * (g + k));
+        a2[index] = g * a1[index];
+        a3[index] = g * a2[index];
+        m1[index] = k * (amplitude * amplitude - FloatType (1));
+    }
+
+    void processChannel(Band& band, size_t channel, FloatType* samples, size_t numSamples, size_t stride) noexcept
+    {
+        auto s1 = band.ic1[channel];
+        auto s2 = band.ic2[channel];
+
+        for (size_t i = 0, c = 0; i < numSamples; ++i, c += stride)
+        {
+            auto x = samples[i];
+            auto v3 = x - s2;
+            auto v1 = a1[c] * s1 + a2[c] * v3;
+            auto v2 = s2 + a2[c] * s1 + a3[c] * v3;
+
+            s1 = FloatType (2) * v1 - s1;
+            s2 = FloatType (2) * v2 - s2;
+
+            samples[i] = x + m1[c] * v1;
+        }
+
+        band.ic1[channel] = s1;
+        band.ic2[channel] = s2;
+    }
+
+    std::array<Band, (size_t) numPeakBands> bands;
+    std::vector<FloatType> a1, a2, a3, m1;
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 0;
+
+    static constexpr double smoothingSeconds = 0.02;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StateVariableBands)
+};
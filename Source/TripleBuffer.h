@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Wait-free single producer / single consumer hand over of a value.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Three preallocated slots: the writer fills its back slot and publishes it,
+    the reader swaps the most recently published slot into its front slot.
+    Neither side ever blocks or allocates, and slots are simply reused, so
+    nothing has to be freed on the reading thread.
+*/
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    //writer side
+    Type& getWriteBuffer() noexcept                 { return buffers[(size_t) backIndex]; }
+
+    void publish() noexcept
+    {
+        auto previous = middle.exchange(backIndex | freshFlag, std::memory_order_acq_rel);
+        backIndex = previous & indexMask;
+    }
+
+    //reader side, returns nullptr when nothing new was published since the last call
+    const Type* acquireLatest() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+            return nullptr;
+
+        auto previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & indexMask;
+        return &buffers[(size_t) frontIndex];
+    }
+
+    const Type& getReadBuffer() const noexcept      { return buffers[(size_t) frontIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<Type, 3> buffers;
+    int backIndex{ 0 }, frontIndex{ 1 };
+    std::atomic<int> middle{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
@@ -0,0 +1,448 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer: streams audio files through SimpleEqAudioProcessor
+    on every core, without an editor or a running message loop.
+
+    SimpleEqBatchRenderer --settings preset.json --output outDir [options] files...
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+struct RenderOptions
+{
+    juce::File outputDirectory;
+    int numThreads = juce::SystemStats::getNumCpus();
+    int numChannelThreads = 0;      //per processor, for files with more channels than there are chunks to share out
+    int blockSize = 1024;
+    double chunkSeconds = 10.0;
+    double warmUpSeconds = 0.0;     //minimum, the processor's tail length is always warmed up
+};
+
+/** Parameter values by id, in real units (choice parameters take their index),
+    or a complete apvts state saved as XML.
+*/
+struct RenderSettings
+{
+    juce::NamedValueSet parameterValues;
+    juce::ValueTree state;
+
+    bool load(const juce::File& file, juce::String& error)
+    {
+        if (! file.existsAsFile())
+        {
+            error = "Settings file not found: " + file.getFullPathName();
+            return false;
+        }
+
+        if (file.hasFileExtension("xml"))
+        {
+            if (auto xml = juce::XmlDocument::parse(file))
+                state = juce::ValueTree::fromXml(*xml);
+
+            if (! state.isValid())
+                error = "Could not read the state in " + file.getFullPathName();
+
+            return state.isValid();
+        }
+
+        auto json = juce::JSON::parse(file);
+
+        if (auto* object = json.getDynamicObject())
+        {
+            parameterValues = object->getProperties();
+            return true;
+        }
+
+        error = "Expected a JSON object of parameter values in " + file.getFullPathName();
+        return false;
+    }
+
+    void applyTo(SimpleEqAudioProcessor& processor) const
+    {
+        if (state.isValid())
+            processor.apvts.replaceState(state.createCopy());
+
+        for (auto& value : parameterValues)
+            if (auto* parameter = processor.apvts.getParameter(value.name.toString()))
+                parameter->setValueNotifyingHost(parameter->convertTo0to1((float) value.value));
+    }
+};
+
+//==============================================================================
+/** One input file. Chunks of it are rendered in parallel, and finished chunks are
+    handed to a write-behind ThreadedWriter strictly in order.
+*/
+class FileRender
+{
+public:
+    FileRender(juce::AudioFormatManager& formats, const juce::File& inputFile, const RenderOptions& options,
+               juce::TimeSliceThread& writeThreadToUse)
+        : formatManager(formats), input(inputFile), writeThread(writeThreadToUse)
+    {
+        if (auto reader = createReader())
+        {
+            sampleRate = reader->sampleRate;
+            numChannels = (int) reader->numChannels;
+            lengthInSamples = reader->lengthInSamples;
+            bitsPerSample = (int) reader->bitsPerSample;
+            metadata = reader->metadataValues;
+        }
+
+        output = getOutputFile(input, options.outputDirectory);
+
+        auto chunkLength = juce::jmax((juce::int64) options.blockSize, (juce::int64) (options.chunkSeconds * sampleRate));
+        numChunks = (int) ((lengthInSamples + chunkLength - 1) / chunkLength);
+        samplesPerChunk = chunkLength;
+    }
+
+    bool isValid() const noexcept   { return numChannels > 0 && lengthInSamples > 0; }
+
+    //same name as the input, so inputs from different directories can ask for the same output
+    static juce::File getOutputFile(const juce::File& inputFile, const juce::File& outputDirectory)
+    {
+        return outputDirectory.getChildFile(inputFile.getFileName());
+    }
+
+    //rendering into the input's own directory would overwrite it
+    static bool wouldOverwrite(const juce::File& inputFile, const juce::File& outputDirectory)
+    {
+        auto source = inputFile.getLinkedTarget();
+        auto destination = outputDirectory.getLinkedTarget();
+
+        return destination == source || destination == source.getParentDirectory();
+    }
+
+    bool openOutput()
+    {
+        if (output.getLinkedTarget() == input.getLinkedTarget())
+            return false;
+
+        auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+
+        if (format == nullptr)
+            return false;
+
+        output.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(output);
+
+        if (! stream->openedOk())
+            return false;
+
+        auto bits = format->getPossibleBitDepths().contains(bitsPerSample) ? bitsPerSample : format->getPossibleBitDepths().getLast();
+
+        if (auto* writer = format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels, bits, metadata, 0))
+        {
+            stream.release();
+            threadedWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(writer, writeThread, writeBehindSamples);
+            return true;
+        }
+
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> createReader() const
+    {
+        return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(input));
+    }
+
+    void chunkFinished(int chunkIndex, juce::AudioBuffer<float>&& audio)
+    {
+        const juce::ScopedLock sl(writeLock);
+
+        finishedChunks.emplace(chunkIndex, std::move(audio));
+
+        for (auto it = finishedChunks.find(nextChunkToWrite); it != finishedChunks.end(); it = finishedChunks.find(nextChunkToWrite))
+        {
+            write(it->second);
+            finishedChunks.erase(it);
+            ++nextChunkToWrite;
+        }
+
+        //the writer flushes what is left of its FIFO and closes the file
+        if (nextChunkToWrite == numChunks)
+            threadedWriter.reset();
+    }
+
+    const juce::File& getInput() const noexcept     { return input; }
+    double getSampleRate() const noexcept           { return sampleRate; }
+    int getNumChannels() const noexcept             { return numChannels; }
+    juce::int64 getLength() const noexcept          { return lengthInSamples; }
+    juce::int64 getSamplesPerChunk() const noexcept { return samplesPerChunk; }
+    int getNumChunks() const noexcept               { return numChunks; }
+
+private:
+    void write(const juce::AudioBuffer<float>& audio)
+    {
+        juce::HeapBlock<const float*> channels((size_t) audio.getNumChannels());
+
+        //the FIFO is bounded, so wait for the background thread to drain it when full
+        for (int position = 0; position < audio.getNumSamples();)
+        {
+            auto numToWrite = juce::jmin(writeBehindSamples / 2, audio.getNumSamples() - position);
+
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                channels[channel] = audio.getReadPointer(channel, position);
+
+            if (threadedWriter->write(channels.getData(), numToWrite))
+                position += numToWrite;
+            else
+                juce::Thread::sleep(1);
+        }
+    }
+
+    static constexpr int writeBehindSamples = 1 << 16;
+
+    juce::AudioFormatManager& formatManager;
+    juce::File input, output;
+    juce::TimeSliceThread& writeThread;
+
+    double sampleRate = 0.0;
+    int numChannels = 0, bitsPerSample = 24, numChunks = 0;
+    juce::int64 lengthInSamples = 0, samplesPerChunk = 0;
+    juce::StringPairArray metadata;
+
+    juce::CriticalSection writeLock;
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> threadedWriter;
+    std::map<int, juce::AudioBuffer<float>> finishedChunks;
+    int nextChunkToWrite = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(FileRender)
+};
+
+//==============================================================================
+/** Renders one chunk with its own processor instance. The filter state is warmed
+    up on the audio preceding the chunk, so chunk boundaries are inaudible. In
+    linear phase mode the input runs latency samples ahead of the output, which
+    is shifted back into line with the source.
+*/
+class ChunkRenderJob : public juce::ThreadPoolJob
+{
+public:
+    ChunkRenderJob(FileRender& fileToRender, int chunk, const RenderSettings& settingsToUse,
+                   const RenderOptions& optionsToUse, juce::TimeSliceThread& readThreadToUse)
+        : juce::ThreadPoolJob(fileToRender.getInput().getFileName() + " #" + juce::String(chunk)),
+          file(fileToRender), chunkIndex(chunk), settings(settingsToUse), options(optionsToUse), readThread(readThreadToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto numChannels = file.getNumChannels();
+        auto chunkStart = (juce::int64) chunkIndex * file.getSamplesPerChunk();
+        auto chunkLength = (int) juce::jmin(file.getSamplesPerChunk(), file.getLength() - chunkStart);
+        //read-ahead happens on the shared read thread while this one filters
+        juce::BufferingAudioReader reader(file.createReader().release(), readThread, options.blockSize * 8);
+        reader.setReadTimeout(-1);
+
+        SimpleEqAudioProcessor processor;
+        settings.applyTo(processor);
+        processor.setNumWorkerThreads(options.numChannelThreads);
+        processor.setPlayConfigDetails(numChannels, numChannels, file.getSampleRate(), options.blockSize);
+        processor.prepareToPlay(file.getSampleRate(), options.blockSize);
+
+        //the filters settle within their tail, which the settings decide
+        auto warmUpSeconds = juce::jmax(options.warmUpSeconds, processor.getTailLengthSeconds());
+        auto warmUpStart = juce::jmax((juce::int64) 0, chunkStart - (juce::int64) std::ceil(warmUpSeconds * file.getSampleRate()));
+
+        if (! processor.waitForLinearPhaseKernel(kernelTimeoutMs))
+            std::cerr << getJobName() << ": the linear phase kernel did not load in time" << std::endl;
+
+        //linear phase mode delays the output, so the input is fed that much further, zeros past the end,
+        //and every output block lands latency samples earlier in the source's timeline
+        auto latency = (juce::int64) processor.getLatencySamples();
+        auto chunkEnd = chunkStart + chunkLength;
+
+        juce::AudioBuffer<float> block(numChannels, options.blockSize);
+        juce::AudioBuffer<float> rendered(numChannels, chunkLength);
+        juce::MidiBuffer midi;
+
+        for (auto position = warmUpStart; position < chunkEnd + latency;)
+        {
+            auto numSamples = (int) juce::jmin((juce::int64) options.blockSize, chunkEnd + latency - position);
+
+            block.setSize(numChannels, numSamples, false, false, true);
+            reader.read(&block, 0, numSamples, position, true, true);
+            processor.processBlock(block, midi);
+
+            //the part of the block that belongs to the chunk, the first latency samples of a file only hold the pre-roll
+            auto outputStart = juce::jmax(position - latency, chunkStart);
+            auto outputEnd = juce::jmin(position - latency + numSamples, chunkEnd);
+
+            if (outputStart < outputEnd)
+                for (int channel = 0; channel < numChannels; ++channel)
+                    rendered.copyFrom(channel, (int) (outputStart - chunkStart), block, channel,
+                                      (int) (outputStart - (position - latency)), (int) (outputEnd - outputStart));
+
+            position += numSamples;
+        }
+
+        processor.releaseResources();
+        file.chunkFinished(chunkIndex, std::move(rendered));
+
+        return jobHasFinished;
+    }
+
+private:
+    static constexpr int kernelTimeoutMs = 10000;
+
+    FileRender& file;
+    int chunkIndex;
+    const RenderSettings& settings;
+    const RenderOptions& options;
+    juce::TimeSliceThread& readThread;
+
+    JUCE_DECLARE_NON_COPYABLE(ChunkRenderJob)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: SimpleEqBatchRenderer --settings <preset.json|state.xml> --output <dir>" << std::endl
+              << "                             [--threads N] [--channel-threads N] [--block-size N] [--chunk-seconds S]" << std::endl
+              << "                             [--warmup-seconds S] files..." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    //the processor's apvts expects JUCE to be initialised, no message loop is ever run
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    RenderOptions options;
+    RenderSettings settings;
+    juce::String error;
+
+    if (! args.containsOption("--settings") || ! args.containsOption("--output"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (! settings.load(args.getFileForOption("--settings"), error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    options.outputDirectory = args.getFileForOption("--output");
+
+    if (options.outputDirectory.existsAsFile() || options.outputDirectory.createDirectory().failed())
+    {
+        std::cerr << "Not a usable output directory: " << options.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (args.containsOption("--threads"))
+        options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    if (args.containsOption("--channel-threads"))
+        options.numChannelThreads = juce::jmax(0, args.getValueForOption("--channel-threads").getIntValue());
+
+    if (args.containsOption("--block-size"))
+        options.blockSize = juce::jlimit(16, 65536, args.getValueForOption("--block-size").getIntValue());
+
+    if (args.containsOption("--chunk-seconds"))
+        options.chunkSeconds = juce::jmax(1.0, args.getValueForOption("--chunk-seconds").getDoubleValue());
+
+    if (args.containsOption("--warmup-seconds"))
+        options.warmUpSeconds = juce::jmax(0.0, args.getValueForOption("--warmup-seconds").getDoubleValue());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::TimeSliceThread readThread("SimpleEq read-ahead"), writeThread("SimpleEq write-behind");
+    readThread.startThread();
+    writeThread.startThread();
+
+    juce::OwnedArray<FileRender> files;
+
+    //outputs taken so far and the input rendering to each, lower case so that names differing
+    //only in case collide on any file system
+    std::map<juce::String, juce::File> claimedOutputs;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        auto arg = args[i];
+
+        //every option takes a value, either as --option=value or as the next argument
+        if (arg.isOption())
+        {
+            if (! arg.text.contains("="))
+                ++i;
+
+            continue;
+        }
+
+        auto inputFile = arg.resolveAsFile();
+
+        if (! inputFile.existsAsFile())
+        {
+            std::cerr << "File not found: " << inputFile.getFullPathName() << std::endl;
+            continue;
+        }
+
+        if (FileRender::wouldOverwrite(inputFile, options.outputDirectory))
+        {
+            std::cerr << "Skipping " << inputFile.getFullPathName() << ", the output would overwrite it" << std::endl;
+            continue;
+        }
+
+        //the first file to ask for a name keeps it, rather than the last one silently replacing its render
+        auto outputFile = FileRender::getOutputFile(inputFile, options.outputDirectory);
+        auto claimed = claimedOutputs.find(outputFile.getFullPathName().toLowerCase());
+
+        if (claimed != claimedOutputs.end())
+        {
+            std::cerr << "Skipping " << inputFile.getFullPathName() << ", " << claimed->second.getFullPathName()
+                      << " already renders to " << outputFile.getFullPathName() << std::endl;
+            continue;
+        }
+
+        auto* file = files.add(new FileRender(formatManager, inputFile, options, writeThread));
+
+        if (! file->isValid() || ! file->openOutput())
+        {
+            std::cerr << "Skipping " << inputFile.getFullPathName() << std::endl;
+            files.removeLast();
+            continue;
+        }
+
+        claimedOutputs[outputFile.getFullPathName().toLowerCase()] = inputFile;
+    }
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    double totalAudioSeconds = 0.0;
+
+    {
+        juce::ThreadPool pool(options.numThreads);
+
+        //chunks are queued file by file, so finished chunks mostly arrive in write order
+        for (auto* file : files)
+        {
+            totalAudioSeconds += (double) file->getLength() / file->getSampleRate();
+
+            for (int chunk = 0; chunk < file->getNumChunks(); ++chunk)
+                pool.addJob(new ChunkRenderJob(*file, chunk, settings, options, readThread), true);
+        }
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(20);
+    }
+
+    auto numFiles = files.size();
+    files.clear();
+    writeThread.stopThread(10000);
+    readThread.stopThread(1000);
+
+    auto seconds = juce::jmax(1.0e-3, (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0);
+
+    std::cout << "Rendered " << numFiles << " files, " << totalAudioSeconds << " s of audio in " << seconds << " s ("
+              << totalAudioSeconds / seconds << "x real time, " << 3600.0 * numFiles / seconds << " files/hour)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,325 @@
+/*
+  ==============================================================================
+
+    DSP benchmark: drives SimpleEqAudioProcessor::processBlock directly with
+    synthetic buffers across a matrix of configurations, in single and double
+    precision.
+
+    SimpleEqBenchmark [--full] [--output results.json] [--worker-threads N]
+                      [--baseline baseline.json] [--tolerance 0.1]
+
+    Coefficient design runs on the benchmark thread right before each block
+    instead of on the background design thread, so the timings of automated
+    cases include it, as they would for an offline render.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../Shared/AllocationCounter.h"
+
+//==============================================================================
+enum class Automation
+{
+    none,       //parameters set once before measuring
+    perBlock,   //a band jumps between two settings every block
+    sweep       //every active band sweeps continuously
+};
+
+static const char* getAutomationName(Automation automation)
+{
+    switch (automation)
+    {
+    case Automation::perBlock: return "perBlock";
+    case Automation::sweep:    return "sweep";
+    default:                   return "static";
+    }
+}
+
+struct BenchmarkCase
+{
+    int blockSize = 512;
+    double sampleRate = 48000.0;
+    int numChannels = 2;
+    int slope = 0;
+    int numActiveBands = 0;     //peaks first, then low cut and high cut
+    Automation automation = Automation::none;
+    bool doublePrecision = false;
+    int workerThreads = 0;
+
+    //float, single threaded keys are unchanged from before those options existed, so old baselines still match
+    juce::String getKey() const
+    {
+        return juce::String(blockSize) + "/" + juce::String((int) sampleRate) + "/" + juce::String(numChannels) + "/"
+             + juce::String(slope) + "/" + juce::String(numActiveBands) + "/" + getAutomationName(automation)
+             + (doublePrecision ? "/double" : "")
+             + (workerThreads > 0 ? "/threads" + juce::String(workerThreads) : "");
+    }
+};
+
+struct BenchmarkResult
+{
+    double nsPerSample = 0.0;       //per channel sample
+    double meanBlockMicroseconds = 0.0;
+    double worstBlockMicroseconds = 0.0;
+    double meanDesignMicroseconds = 0.0;    //the part of the block time spent designing coefficients
+    double allocationsPerBlock = 0.0;       //processBlock only, designs may allocate
+};
+
+//==============================================================================
+static void setParameter(SimpleEqAudioProcessor& processor, const juce::String& id, float value)
+{
+    if (auto* parameter = processor.apvts.getParameter(id))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+static void setActiveBands(SimpleEqAudioProcessor& processor, const BenchmarkCase& c, float sweepPosition)
+{
+    //sweepPosition in 0..1 moves every active band across a couple of octaves
+    auto octaves = 2.f * sweepPosition;
+
+    for (int peak = 0; peak < numPeakBands; ++peak)
+    {
+        auto active = peak < c.numActiveBands;
+
+        //spread the peaks over 100 Hz .. 12.8 kHz whatever the band count
+        auto spacing = numPeakBands > 1 ? 7.f / (float) (numPeakBands - 1) : 0.f;
+
+        setParameter(processor, ChainParameters::getPeakParameterID(peak, "Freq"), 100.f * std::pow(2.f, (float) peak * spacing + octaves));
+        setParameter(processor, ChainParameters::getPeakParameterID(peak, "Gain"), active ? 6.f : 0.f);
+        setParameter(processor, ChainParameters::getPeakParameterID(peak, "Quality"), 1.f);
+    }
+
+    setParameter(processor, "LowCut Freq", c.numActiveBands > numPeakBands ? 40.f * std::pow(2.f, octaves) : 20.f);
+    setParameter(processor, "HighCut Freq", c.numActiveBands > numPeakBands + 1 ? 5000.f * std::pow(2.f, octaves) : 20000.f);
+    setParameter(processor, "LowCut Slope", (float) c.slope);
+    setParameter(processor, "HighCut Slope", (float) c.slope);
+}
+
+template <typename FloatType>
+static BenchmarkResult runCase(const BenchmarkCase& c, int samplesToProcess)
+{
+    SimpleEqAudioProcessor processor;
+    processor.setDesignOnCallingThread(true);
+    setActiveBands(processor, c, 0.f);
+    processor.setNumWorkerThreads(c.workerThreads);
+    processor.setProcessingPrecision(c.doublePrecision ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+    processor.setPlayConfigDetails(c.numChannels, c.numChannels, c.sampleRate, c.blockSize);
+    processor.prepareToPlay(c.sampleRate, c.blockSize);
+
+    juce::AudioBuffer<FloatType> buffer(c.numChannels, c.blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(0x5eed);
+
+    auto fillNoise = [&]
+    {
+        for (int channel = 0; channel < c.numChannels; ++channel)
+            for (int i = 0; i < c.blockSize; ++i)
+                buffer.setSample(channel, i, (FloatType) (random.nextFloat() * 0.5f - 0.25f));
+    };
+
+    //let caches and the filter state settle before measuring
+    for (int i = 0; i < 16; ++i)
+    {
+        fillNoise();
+        processor.designPendingCoefficients();
+        processor.processBlock(buffer, midi);
+    }
+
+    auto numBlocks = juce::jmax(1, samplesToProcess / c.blockSize);
+    double totalSeconds = 0.0, worstSeconds = 0.0, designSeconds = 0.0;
+    juce::int64 allocations = 0;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        fillNoise();
+
+        if (c.automation == Automation::perBlock)
+            setParameter(processor, "Peak1 Gain", (block & 1) != 0 ? -6.f : 6.f);
+        else if (c.automation == Automation::sweep)
+            setActiveBands(processor, c, (float) block / (float) numBlocks);
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        //what the parameter changes above marked dirty is designed as part of the block
+        processor.designPendingCoefficients();
+
+        auto designed = juce::Time::getHighResolutionTicks();
+
+        {
+            //on every thread, the channel worker pool's included
+            ScopedAllocationCounter counter(ScopedAllocationCounter::Threads::all);
+            processor.processBlock(buffer, midi);
+            allocations += counter.getCount();
+        }
+
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+        designSeconds += juce::Time::highResolutionTicksToSeconds(designed - start);
+        totalSeconds += elapsed;
+        worstSeconds = juce::jmax(worstSeconds, elapsed);
+    }
+
+    processor.releaseResources();
+
+    BenchmarkResult result;
+    result.nsPerSample = 1.0e9 * totalSeconds / ((double) numBlocks * c.blockSize * c.numChannels);
+    result.meanBlockMicroseconds = 1.0e6 * totalSeconds / numBlocks;
+    result.worstBlockMicroseconds = 1.0e6 * worstSeconds;
+    result.meanDesignMicroseconds = 1.0e6 * designSeconds / numBlocks;
+    result.allocationsPerBlock = (double) allocations / numBlocks;
+    return result;
+}
+
+//==============================================================================
+static juce::Array<BenchmarkCase> createCases(bool full, int workerThreads)
+{
+    juce::Array<int> blockSizes { 16, 64, 256, 1024, 4096 };
+    juce::Array<double> sampleRates { 44100.0, 96000.0 };
+    juce::Array<int> channelCounts { 1, 2, 8, 16 };
+    juce::Array<int> slopes { 0, 3 };
+    juce::Array<int> activeBands { 0, 2, numPeakBands + 2 };
+
+    if (full)
+    {
+        blockSizes = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        sampleRates = { 44100.0, 48000.0, 96000.0, 192000.0 };
+        channelCounts = { 1, 2, 6, 8, 12, 16 };
+        slopes = { 0, 1, 2, 3 };
+        activeBands.clear();
+
+        for (int n = 0; n <= numPeakBands + 2; ++n)
+            activeBands.add(n);
+    }
+
+    //the pool only runs for wide buses, so those are what a threaded run measures
+    if (workerThreads > 0)
+        channelCounts = { SimpleEqAudioProcessor::minParallelChannels, 32, 64, SimpleEqAudioProcessor::maxNumChannels };
+
+    juce::Array<BenchmarkCase> cases;
+
+    for (auto blockSize : blockSizes)
+        for (auto sampleRate : sampleRates)
+            for (auto numChannels : channelCounts)
+                for (auto slope : slopes)
+                    for (auto numActiveBands : activeBands)
+                        for (auto automation : { Automation::none, Automation::perBlock, Automation::sweep })
+                            for (auto doublePrecision : { false, true })
+                                cases.add({ blockSize, sampleRate, numChannels, slope, numActiveBands, automation, doublePrecision, workerThreads });
+
+    return cases;
+}
+
+static juce::var toVar(const BenchmarkCase& c, const BenchmarkResult& r)
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty("key", c.getKey());
+    object->setProperty("blockSize", c.blockSize);
+    object->setProperty("sampleRate", c.sampleRate);
+    object->setProperty("channels", c.numChannels);
+    object->setProperty("slope", c.slope);
+    object->setProperty("activeBands", c.numActiveBands);
+    object->setProperty("automation", getAutomationName(c.automation));
+    object->setProperty("precision", c.doublePrecision ? "double" : "float");
+    object->setProperty("workerThreads", c.workerThreads);
+    object->setProperty("nsPerSample", r.nsPerSample);
+    object->setProperty("meanBlockUs", r.meanBlockMicroseconds);
+    object->setProperty("worstBlockUs", r.worstBlockMicroseconds);
+    object->setProperty("meanDesignUs", r.meanDesignMicroseconds);
+    object->setProperty("allocationsPerBlock", r.allocationsPerBlock);
+    return juce::var(object);
+}
+
+//returns the number of cases that got slower than the baseline by more than the tolerance
+static int compareWithBaseline(const juce::Array<juce::var>& results, const juce::File& baselineFile, double tolerance)
+{
+    auto baseline = juce::JSON::parse(baselineFile);
+
+    if (! baseline.isArray())
+    {
+        std::cerr << "Could not read baseline " << baselineFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::map<juce::String, juce::var> baselineByKey;
+
+    for (auto& entry : *baseline.getArray())
+        baselineByKey[entry["key"].toString()] = entry;
+
+    int regressions = 0;
+
+    for (auto& result : results)
+    {
+        auto it = baselineByKey.find(result["key"].toString());
+
+        if (it == baselineByKey.end())
+            continue;
+
+        auto before = (double) it->second["nsPerSample"];
+        auto after = (double) result["nsPerSample"];
+        auto newAllocations = (double) result["allocationsPerBlock"] > (double) it->second["allocationsPerBlock"];
+
+        if (after > before * (1.0 + tolerance) || newAllocations)
+        {
+            ++regressions;
+            std::cout << "REGRESSION " << result["key"].toString() << ": " << before << " -> " << after << " ns/sample, "
+                      << (double) result["allocationsPerBlock"] << " allocations/block" << std::endl;
+        }
+    }
+
+    return regressions;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    auto workerThreads = args.containsOption("--worker-threads") ? juce::jmax(0, args.getValueForOption("--worker-threads").getIntValue()) : 0;
+    auto cases = createCases(args.containsOption("--full"), workerThreads);
+    auto samplesPerCase = 1 << 16;
+
+    juce::Array<juce::var> results;
+
+    //every double case directly follows the float case with the same configuration
+    double floatNsPerSample = 0.0, sumOfLogRatios = 0.0;
+    int numRatios = 0;
+
+    for (auto& c : cases)
+    {
+        auto result = c.doublePrecision ? runCase<double>(c, samplesPerCase) : runCase<float>(c, samplesPerCase);
+        results.add(toVar(c, result));
+
+        std::cout << c.getKey() << "  " << result.nsPerSample << " ns/sample, worst block " << result.worstBlockMicroseconds
+                  << " us, design " << result.meanDesignMicroseconds << " us/block, " << result.allocationsPerBlock
+                  << " allocations/block" << std::endl;
+
+        if (! c.doublePrecision)
+        {
+            floatNsPerSample = result.nsPerSample;
+        }
+        else if (floatNsPerSample > 0.0 && result.nsPerSample > 0.0)
+        {
+            sumOfLogRatios += std::log(result.nsPerSample / floatNsPerSample);
+            ++numRatios;
+        }
+    }
+
+    if (numRatios > 0)
+        std::cout << "double precision costs " << std::exp(sumOfLogRatios / numRatios) << "x float (geometric mean)" << std::endl;
+
+    if (args.containsOption("--output"))
+        args.getFileForOption("--output").replaceWithText(juce::JSON::toString(juce::var(results)));
+
+    if (args.containsOption("--baseline"))
+    {
+        auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getDoubleValue() : 0.1;
+        auto regressions = compareWithBaseline(results, args.getFileForOption("--baseline"), tolerance);
+
+        std::cout << regressions << " regressions against the baseline" << std::endl;
+        return regressions > 0 ? 1 : 0;
+    }
+
+    return 0;
+}
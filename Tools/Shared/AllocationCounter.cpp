@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.cpp
+
+  ==============================================================================
+*/
+
+#include "AllocationCounter.h"
+
+//constant initialised, so they are ready for allocations made before any static constructor runs. The thread
+//locals are plain values in the executable's own TLS block, reading them never allocates
+static std::atomic<int> numAllThreadCounters{ 0 };
+static std::atomic<juce::int64> numAllocations{ 0 };
+static thread_local int numThreadCounters = 0;
+static thread_local juce::int64 numThreadAllocations = 0;
+
+static void countAllocation() noexcept
+{
+    if (numThreadCounters > 0)
+        ++numThreadAllocations;
+
+    if (numAllThreadCounters.load(std::memory_order_relaxed) > 0)
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScopedAllocationCounter::ScopedAllocationCounter(Threads threadsToCount) noexcept
+    : threads(threadsToCount),
+      startCount(threadsToCount == Threads::all ? numAllocations.load() : numThreadAllocations)
+{
+    if (threads == Threads::all)
+        ++numAllThreadCounters;
+    else
+        ++numThreadCounters;
+}
+
+ScopedAllocationCounter::~ScopedAllocationCounter() noexcept
+{
+    if (threads == Threads::all)
+        --numAllThreadCounters;
+    else
+        --numThreadCounters;
+}
+
+juce::int64 ScopedAllocationCounter::getCount() const noexcept
+{
+    return (threads == Threads::all ? numAllocations.load() : numThreadAllocations) - startCount;
+}
+
+//==============================================================================
+#if JUCE_LINUX && defined (__GLIBC__)
+
+//glibc exports its allocator under these names too, definitions here take precedence over the
+//library's malloc for the whole process, operator new included
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+
+        if (alignment % sizeof(void*) != 0 || ! juce::isPowerOfTwo(alignment))
+            return EINVAL;
+
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+}
+
+#else
+
+static void* allocate(std::size_t size) noexcept
+{
+    countAllocation();
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+    countAllocation();
+
+   #if JUCE_WINDOWS
+    return _aligned_malloc(size == 0 ? 1 : size, (std::size_t) alignment);
+   #else
+    void* result = nullptr;
+    return posix_memalign(&result, juce::jmax((std::size_t) alignment, sizeof(void*)), size == 0 ? 1 : size) == 0 ? result : nullptr;
+   #endif
+}
+
+static void freeAligned(void* pointer) noexcept
+{
+   #if JUCE_WINDOWS
+    _aligned_free(pointer);
+   #else
+    std::free(pointer);
+   #endif
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto* pointer = allocate(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* pointer = allocateAligned(size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)                                                          { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t alignment)                              { return operator new(size, alignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept                            { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                          { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept  { return allocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept                                                    { std::free(pointer); }
+void operator delete[](void* pointer) noexcept                                                  { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept                                       { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept                                     { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                             { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept                           { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                                  { freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                                { freeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept                     { freeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept                   { freeAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept           { freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept         { freeAligned(pointer); }
+
+#endif
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.h
+    Counts heap allocations made while processing is measured.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Counts the heap allocations made by the thread that created the counter, so
+    whatever other threads happen to do meanwhile cannot make a check of that
+    thread fail. Asked to count all threads instead, it sees every allocation in
+    the process while it exists, the channel worker pool's threads included, and
+    busy background threads with them.
+
+    On Linux with glibc the C allocator itself is interposed (malloc, calloc,
+    realloc and the aligned variants), which covers operator new in all its
+    forms and anything system libraries allocate. Elsewhere the global
+    operator new and delete are replaced, aligned and nothrow forms included,
+    and direct calls to malloc are not seen.
+
+    Link AllocationCounter.cpp into console tools only, never into the plugin.
+*/
+class ScopedAllocationCounter
+{
+public:
+    enum class Threads
+    {
+        calling,
+        all
+    };
+
+    explicit ScopedAllocationCounter(Threads threadsToCount = Threads::calling) noexcept;
+    ~ScopedAllocationCounter() noexcept;
+
+    //allocations since this counter was created. Counting the calling thread, ask on that thread
+    juce::int64 getCount() const noexcept;
+
+private:
+    Threads threads;
+    juce::int64 startCount;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationCounter)
+};
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    CascadeTests.cpp
+    The processor's chain against the per channel chains of IIR::Filters it
+    replaced.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+/**
+    Runs the same noise through SimpleEqAudioProcessor and through one chain of
+    juce::dsp::IIR::Filters per channel, as the original MonoChain did, with the
+    sections designed in double from the values the parameters snapped to and
+    rounded like the cascade rounds them. The two do the same arithmetic in the
+    same order, so they only part by rounding: fused multiply-adds on one side
+    and IIR::Filter snapping tiny states to zero at the end of every block. In
+    float, contracted against plain arithmetic, that reaches about 2e-4 on these
+    settings, hence the tolerance of -60 dB.
+*/
+class CascadeTests : public juce::UnitTest
+{
+public:
+    CascadeTests() : juce::UnitTest("Processor against IIR::Filter chains", "SimpleEq") {}
+
+    void runTest() override
+    {
+        for (int slope = 0; slope < 4; ++slope)
+        {
+            beginTest(juce::String(12 * (slope + 1)) + " dB/oct cuts");
+
+            //counts that are not a multiple of the SIMD width leave spare lanes in the last group
+            for (auto numChannels : { 1, 2, 3, 4, 5, 8, 11 })
+            {
+                compare<float>(slope, numChannels, 1.0e-3f);
+                compare<double>(slope, numChannels, 1.0e-10);
+            }
+        }
+    }
+
+private:
+    static void setParameter(SimpleEqAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    //every band active: both cuts at the given slope and every peak boosting or cutting
+    static void setParameters(SimpleEqAudioProcessor& processor, int slope)
+    {
+        setParameter(processor, "LowCut Freq", 80.f);
+        setParameter(processor, "HighCut Freq", 8000.f);
+        setParameter(processor, "LowCut Slope", (float) slope);
+        setParameter(processor, "HighCut Slope", (float) slope);
+
+        for (int peak = 0; peak < numPeakBands; ++peak)
+        {
+            //spread over 100 Hz .. 12.8 kHz whatever the band count, with Qs the parameter range holds exactly
+            auto spacing = numPeakBands > 1 ? 7.f / (float) (numPeakBands - 1) : 0.f;
+
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Freq"), 100.f * std::pow(2.f, (float) peak * spacing));
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Quality"), juce::jmin(10.f, 0.5f + (float) peak));
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Gain"), (peak & 1) != 0 ? -6.f : 9.f);
+        }
+    }
+
+    //designed in double the way the plugin designs them, from the snapped parameter values
+    static juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<double>> designSections(juce::AudioProcessorValueTreeState& apvts, int slope, double rate)
+    {
+        auto value = [&apvts](const juce::String& id) { return apvts.getRawParameterValue(id)->load(); };
+        auto order = 2 * (slope + 1);
+
+        auto sections = juce::dsp::FilterDesign<double>::designIIRHighpassHighOrderButterworthMethod(value("LowCut Freq"), rate, order);
+
+        for (int peak = 0; peak < numPeakBands; ++peak)
+        {
+            sections.add(juce::dsp::IIR::Coefficients<double>::makePeakFilter(rate, value(ChainParameters::getPeakParameterID(peak, "Freq")),
+                                                                              value(ChainParameters::getPeakParameterID(peak, "Quality")),
+                                                                              juce::Decibels::decibelsToGain((double) value(ChainParameters::getPeakParameterID(peak, "Gain")))));
+        }
+
+        sections.addArray(juce::dsp::FilterDesign<double>::designIIRLowpassHighOrderButterworthMethod(value("HighCut Freq"), rate, order));
+        return sections;
+    }
+
+    template <typename FloatType>
+    void compare(int slope, int numChannels, FloatType tolerance)
+    {
+        using Filter = juce::dsp::IIR::Filter<FloatType>;
+
+        SimpleEqAudioProcessor processor;
+        setParameters(processor, slope);
+
+        auto layout = processor.getBusesLayout();
+        layout.inputBuses.getReference(0) = juce::AudioChannelSet::discreteChannels(numChannels);
+        layout.outputBuses.getReference(0) = juce::AudioChannelSet::discreteChannels(numChannels);
+
+        if (! processor.setBusesLayout(layout))
+        {
+            expect(false, juce::String(numChannels) + " channels were refused");
+            return;
+        }
+
+        processor.setProcessingPrecision(std::is_same<FloatType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                 : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, maximumBlockSize);
+        processor.prepareToPlay(sampleRate, maximumBlockSize);
+
+        auto sections = designSections(processor.apvts, slope, sampleRate);
+        juce::OwnedArray<juce::OwnedArray<Filter>> chains;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* chain = chains.add(new juce::OwnedArray<Filter>());
+
+            //rounded to FloatType the same way the cascade rounds them
+            for (auto* section : sections)
+            {
+                auto* raw = section->getRawCoefficients();
+                auto* coefficients = new juce::dsp::IIR::Coefficients<FloatType>((FloatType) raw[0], (FloatType) raw[1], (FloatType) raw[2],
+                                                                                 FloatType (1), (FloatType) raw[3], (FloatType) raw[4]);
+                chain->add(new Filter(coefficients))->prepare({ sampleRate, (juce::uint32) maximumBlockSize, 1 });
+            }
+        }
+
+        juce::AudioBuffer<FloatType> processed(numChannels, numSamples), reference(numChannels, numSamples);
+        juce::Random random(0x5eed);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                processed.setSample(channel, i, (FloatType) (random.nextFloat() - 0.5f));
+
+        reference.makeCopyOf(processed);
+        juce::MidiBuffer midi;
+
+        //irregular block sizes, down to single samples
+        for (int start = 0, blockIndex = 0; start < numSamples; ++blockIndex)
+        {
+            auto blockSize = juce::jmin(blockSizes[(size_t) blockIndex % blockSizes.size()], numSamples - start);
+
+            //refers to the samples in place, as a host's buffer would
+            juce::AudioBuffer<FloatType> block(processed.getArrayOfWritePointers(), numChannels, start, blockSize);
+            processor.processBlock(block, midi);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto channelBlock = juce::dsp::AudioBlock<FloatType>(reference).getSingleChannelBlock((size_t) channel)
+                                                                               .getSubBlock((size_t) start, (size_t) blockSize);
+
+                for (auto* filter : *chains[channel])
+                    filter->process(juce::dsp::ProcessContextReplacing<FloatType>(channelBlock));
+            }
+
+            start += blockSize;
+        }
+
+        processor.releaseResources();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            FloatType error (0);
+
+            for (int i = 0; i < numSamples; ++i)
+                error = juce::jmax(error, std::abs(processed.getSample(channel, i) - reference.getSample(channel, i)));
+
+            expect(error <= tolerance, juce::String(numChannels) + " channels, channel " + juce::String(channel)
+                                       + (std::is_same<FloatType, double>::value ? " (double)" : " (float)")
+                                       + ": max error " + juce::String((double) error));
+        }
+    }
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int maximumBlockSize = 512;
+    static constexpr int numSamples = 8192;
+    static constexpr std::array<int, 5> blockSizes { 512, 37, 1, 256, 130 };
+};
+
+static CascadeTests cascadeTests;
@@ -0,0 +1,614 @@
+/*
+  ==============================================================================
+
+    GoldenTests.cpp
+
+  ==============================================================================
+*/
+
+#include "GoldenTests.h"
+#include "../../../Source/PluginProcessor.h"
+#include "../../Shared/AllocationCounter.h"
+
+//==============================================================================
+struct GoldenPeak
+{
+    float freq, gainInDecibels, quality;
+};
+
+struct GoldenSettings
+{
+    const char* name;
+    float lowCutFreq, highCutFreq;
+    int slope;
+    bool peaks;     //the four goldenPeaks, otherwise every peak at its 0 dB default
+};
+
+//the original plugin had exactly four peaks, between the low cut and the high cut
+static constexpr int numGoldenPeaks = 4;
+static const GoldenPeak goldenPeaks[numGoldenPeaks] { { 80.f, 6.f, 0.7f }, { 400.f, -4.f, 2.f }, { 2500.f, 3.f, 1.f }, { 9000.f, -6.f, 4.f } };
+
+static const GoldenSettings goldenSettings[]
+{
+    { "flat",       20.f,  20000.f, 0, false },
+    { "peaks",      20.f,  20000.f, 0, true },
+    { "cuts0",      120.f, 6000.f,  0, false },
+    { "cuts1",      120.f, 6000.f,  1, false },
+    { "cuts2",      120.f, 6000.f,  2, false },
+    { "cuts3",      120.f, 6000.f,  3, false },
+    { "everything", 60.f,  12000.f, 3, true }
+};
+
+static const double goldenSampleRates[] { 44100.0, 48000.0, 96000.0 };
+static const char* const goldenStimuli[] { "impulse", "sweep", "noise" };
+
+static constexpr int goldenLength = 2048;
+static constexpr int goldenMaximumBlockSize = 512;
+
+//block sizes cycle through these, so partial and single sample blocks are covered too
+static const int goldenBlockSizes[] { 256, 61, 512, 1, 130 };
+
+static constexpr int goldenMagic = 0x474c4453;     //"SDLG" read little endian
+static constexpr int goldenFileVersion = 2;
+
+static juce::String getGoldenKey(const GoldenSettings& settings, double sampleRate, int stimulus)
+{
+    return juce::String(settings.name) + "/" + juce::String((int) sampleRate) + "/" + goldenStimuli[stimulus];
+}
+
+//impulse, exponential sine sweep from 20 Hz to 20 kHz, or white noise from a fixed LCG,
+//written out here so that the stored renders do not depend on juce::Random
+static std::vector<float> createStimulus(int stimulus, double sampleRate)
+{
+    std::vector<float> samples((size_t) goldenLength);
+    juce::uint32 state = 0x5eed;
+
+    for (int i = 0; i < goldenLength; ++i)
+    {
+        if (stimulus == 0)
+        {
+            samples[(size_t) i] = i == 0 ? 0.5f : 0.f;
+        }
+        else if (stimulus == 1)
+        {
+            auto rate = std::log(20000.0 / 20.0) / goldenLength;
+            auto phase = juce::MathConstants<double>::twoPi * 20.0 * (std::exp(rate * i) - 1.0) / (rate * sampleRate);
+            samples[(size_t) i] = (float) (0.5 * std::sin(phase));
+        }
+        else
+        {
+            state = state * 1664525u + 1013904223u;
+            samples[(size_t) i] = (float) (state >> 8) / 16777216.0f - 0.5f;
+        }
+    }
+
+    return samples;
+}
+
+//==============================================================================
+/**
+    The processing of the original plugin, one ProcessorChain of IIR::Filters
+    per channel with cut stages beyond the slope bypassed, run in double with
+    coefficients designed in double by the same FilterDesign and Coefficients
+    calls the processor makes. Every 0 dB peak stays in, as it did in the
+    original; in double that changes nothing the tolerances can see.
+*/
+class ReferenceChain
+{
+public:
+    ReferenceChain(const GoldenSettings& settings, double sampleRate)
+    {
+        auto order = 2 * (settings.slope + 1);
+
+        setCut(chain.get<0>(), juce::dsp::FilterDesign<double>::designIIRHighpassHighOrderButterworthMethod(settings.lowCutFreq, sampleRate, order), settings.slope);
+        setCut(chain.get<5>(), juce::dsp::FilterDesign<double>::designIIRLowpassHighOrderButterworthMethod(settings.highCutFreq, sampleRate, order), settings.slope);
+
+        chain.get<1>().coefficients = makePeak(settings, 0, sampleRate);
+        chain.get<2>().coefficients = makePeak(settings, 1, sampleRate);
+        chain.get<3>().coefficients = makePeak(settings, 2, sampleRate);
+        chain.get<4>().coefficients = makePeak(settings, 3, sampleRate);
+
+        chain.prepare({ sampleRate, (juce::uint32) goldenMaximumBlockSize, 1 });
+    }
+
+    void process(juce::dsp::AudioBlock<double>& block)
+    {
+        chain.process(juce::dsp::ProcessContextReplacing<double>(block));
+    }
+
+    //of every stage that is not bypassed
+    double getMagnitudeForFrequency(double freq, double sampleRate) const
+    {
+        double magnitude = 1.0;
+
+        for (auto* coefficients : sections)
+            magnitude *= coefficients->getMagnitudeForFrequency(freq, sampleRate);
+
+        return magnitude;
+    }
+
+private:
+    using Filter = juce::dsp::IIR::Filter<double>;
+    using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+    using CutCoefficients = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<double>>;
+
+    Filter::CoefficientsPtr makePeak(const GoldenSettings& settings, int peak, double sampleRate)
+    {
+        auto band = settings.peaks ? goldenPeaks[peak] : GoldenPeak{ 750.f, 0.f, 1.f };
+
+        return sections.add(juce::dsp::IIR::Coefficients<double>::makePeakFilter(sampleRate, band.freq, band.quality,
+                                                                                 juce::Decibels::decibelsToGain((double) band.gainInDecibels)));
+    }
+
+    template <int Index>
+    void setCutStage(CutFilter& cut, const CutCoefficients& coefficients, int slope)
+    {
+        cut.get<Index>().coefficients = coefficients[Index];
+        cut.setBypassed<Index>(Index > slope);
+
+        if (Index <= slope)
+            sections.add(coefficients[Index]);
+    }
+
+    void setCut(CutFilter& cut, const CutCoefficients& coefficients, int slope)
+    {
+        setCutStage<0>(cut, coefficients, slope);
+        setCutStage<1>(cut, coefficients, slope);
+        setCutStage<2>(cut, coefficients, slope);
+        setCutStage<3>(cut, coefficients, slope);
+    }
+
+    juce::dsp::ProcessorChain<CutFilter, Filter, Filter, Filter, Filter, CutFilter> chain;
+    CutCoefficients sections;
+};
+
+static std::vector<double> renderReference(const GoldenSettings& settings, double sampleRate, int stimulus)
+{
+    auto input = createStimulus(stimulus, sampleRate);
+    std::vector<double> samples(input.begin(), input.end());
+    ReferenceChain reference(settings, sampleRate);
+
+    for (int start = 0, blockIndex = 0; start < goldenLength; ++blockIndex)
+    {
+        auto numSamples = juce::jmin(goldenBlockSizes[blockIndex % (int) std::size(goldenBlockSizes)], goldenLength - start);
+        double* channels[] { samples.data() + start };
+        juce::dsp::AudioBlock<double> block(channels, 1, (size_t) numSamples);
+
+        reference.process(block);
+        start += numSamples;
+    }
+
+    return samples;
+}
+
+bool writeGoldenRenders(const juce::File& file)
+{
+    file.deleteFile();
+    juce::FileOutputStream stream(file);
+
+    if (! stream.openedOk())
+        return false;
+
+    stream.writeInt(goldenMagic);
+    stream.writeInt(goldenFileVersion);
+    stream.writeInt((int) (std::size(goldenSettings) * std::size(goldenSampleRates) * std::size(goldenStimuli)));
+    stream.writeInt(goldenLength);
+
+    for (auto& settings : goldenSettings)
+    {
+        for (auto sampleRate : goldenSampleRates)
+        {
+            for (int stimulus = 0; stimulus < (int) std::size(goldenStimuli); ++stimulus)
+            {
+                stream.writeString(getGoldenKey(settings, sampleRate, stimulus));
+
+                for (auto sample : renderReference(settings, sampleRate, stimulus))
+                    stream.writeFloat((float) sample);
+            }
+        }
+    }
+
+    return stream.getStatus().wasOk();
+}
+
+//==============================================================================
+/**
+    Renders fixed stimuli through SimpleEqAudioProcessor with fixed settings and
+    compares them sample by sample with renders of the reference chain, stored
+    in Golden/golden.bin and built in as binary data. The stored renders are
+    checked against the reference chain first, so a file it cannot reproduce
+    fails on its own. Every processBlock also has to be free of heap
+    allocations on the thread calling it.
+
+    The first channel carries the stimulus, the second an inverted copy at half
+    the level, which has to come out as the inverted, halved golden render.
+    Peaks are checked as biquads, as state variable filters, which have the
+    same response, and as dynamic bands whose threshold is never reached.
+
+    In double the processor is within 1e-7 of the stored renders, most of that
+    their rounding to float, so the tolerance is 1e-5. Processing in float is
+    limited by float itself: the worst of these cases, the 96 kHz sweeps
+    through every band, part from the double renders by up to 7e-4, whichever
+    way the compiler contracts the arithmetic, hence 1e-3 there.
+
+    Linear phase is checked by its response to an impulse, which has to be
+    symmetric about the latency reported to the host and match the reference
+    chain's magnitude between 100 Hz and 15 kHz. With the longest kernel the
+    windowed design is within 0.013 dB of it on these settings.
+*/
+class GoldenTests : public juce::UnitTest
+{
+public:
+    GoldenTests() : juce::UnitTest("Golden renders of the original MonoChain", "SimpleEq") {}
+
+    void runTest() override
+    {
+        beginTest("Allocation counter");
+        {
+            //kept alive outside the counted scope, so the compiler cannot leave the allocation out
+            std::unique_ptr<juce::MemoryBlock> allocated;
+
+            {
+                ScopedAllocationCounter counter;
+                allocated = std::make_unique<juce::MemoryBlock>(1024);
+                expect(counter.getCount() > 0, "an allocation on the calling thread was not counted");
+            }
+
+            //starting a thread allocates on the calling thread, so the counters only exist between
+            //the thread's start and its join, and a thread that allocates nothing is the baseline
+            auto idle = countThreadAllocations(false);
+            auto busy = countThreadAllocations(true);
+
+            expect(busy.callingThread == 0 && idle.callingThread == 0, "another thread's allocation was counted on the calling thread");
+            expect(busy.allThreads > idle.allThreads, "an allocation on another thread was not counted across all threads");
+        }
+
+        std::map<juce::String, std::vector<float>> golden;
+        beginTest("Reading the golden renders");
+        expect(readGolden(golden), "could not read the built in golden renders");
+
+        beginTest("Reference chain against the golden renders");
+        checkReference(golden);
+
+        for (auto& settings : goldenSettings)
+        {
+            beginTest(settings.name);
+
+            if (settings.peaks && numPeakBands < numGoldenPeaks)
+            {
+                logMessage("Skipped, built with fewer than " + juce::String(numGoldenPeaks) + " peak bands");
+                continue;
+            }
+
+            for (auto sampleRate : goldenSampleRates)
+            {
+                for (int stimulus = 0; stimulus < (int) std::size(goldenStimuli); ++stimulus)
+                {
+                    auto key = getGoldenKey(settings, sampleRate, stimulus);
+                    auto it = golden.find(key);
+
+                    if (it == golden.end())
+                    {
+                        expect(false, key + " is missing from the golden renders");
+                        continue;
+                    }
+
+                    for (auto peakMode : { biquadPeaks, stateVariablePeaks, dynamicPeaks })
+                    {
+                        //without peaks the other modes run the same processing as the biquads
+                        if (peakMode != biquadPeaks && ! settings.peaks)
+                            continue;
+
+                        auto name = key + getPeakModeSuffix(peakMode);
+
+                        check<float>(name, settings, peakMode, sampleRate, stimulus, it->second);
+                        check<double>(name + " (double)", settings, peakMode, sampleRate, stimulus, it->second);
+                    }
+                }
+            }
+
+            if (settings.peaks)
+            {
+                beginTest(juce::String(settings.name) + ", linear phase");
+
+                for (auto sampleRate : goldenSampleRates)
+                {
+                    auto name = juce::String(settings.name) + "/" + juce::String((int) sampleRate) + " linear phase";
+
+                    checkLinearPhase<float>(name, settings, sampleRate);
+                    checkLinearPhase<double>(name + " (double)", settings, sampleRate);
+                }
+            }
+        }
+    }
+
+private:
+    enum PeakMode
+    {
+        biquadPeaks,
+        stateVariablePeaks,
+        dynamicPeaks
+    };
+
+    static juce::String getPeakModeSuffix(PeakMode peakMode)
+    {
+        return peakMode == stateVariablePeaks ? " state variable" : peakMode == dynamicPeaks ? " dynamic" : "";
+    }
+
+    struct ThreadAllocations
+    {
+        juce::int64 callingThread, allThreads;
+    };
+
+    static ThreadAllocations countThreadAllocations(bool allocate)
+    {
+        std::unique_ptr<juce::MemoryBlock> allocated;
+        juce::WaitableEvent go;
+
+        std::thread thread([&]
+        {
+            go.wait();
+
+            if (allocate)
+                allocated = std::make_unique<juce::MemoryBlock>(1024);
+        });
+
+        ScopedAllocationCounter callingThread, allThreads(ScopedAllocationCounter::Threads::all);
+        go.signal();
+        thread.join();
+
+        return { callingThread.getCount(), allThreads.getCount() };
+    }
+
+    static bool readGolden(std::map<juce::String, std::vector<float>>& golden)
+    {
+        juce::MemoryInputStream stream(BinaryData::golden_bin, (size_t) BinaryData::golden_binSize, false);
+
+        if (stream.readInt() != goldenMagic || stream.readInt() != goldenFileVersion)
+            return false;
+
+        auto numCases = stream.readInt();
+        auto length = stream.readInt();
+
+        if (length != goldenLength)
+            return false;
+
+        for (int i = 0; i < numCases && ! stream.isExhausted(); ++i)
+        {
+            auto& samples = golden[stream.readString()];
+            samples.resize((size_t) length);
+
+            for (auto& sample : samples)
+                sample = stream.readFloat();
+        }
+
+        return (int) golden.size() == numCases;
+    }
+
+    //what --write-golden would write now, against what is committed
+    void checkReference(const std::map<juce::String, std::vector<float>>& golden)
+    {
+        for (auto& settings : goldenSettings)
+        {
+            for (auto sampleRate : goldenSampleRates)
+            {
+                for (int stimulus = 0; stimulus < (int) std::size(goldenStimuli); ++stimulus)
+                {
+                    auto key = getGoldenKey(settings, sampleRate, stimulus);
+                    auto it = golden.find(key);
+
+                    if (it == golden.end())
+                        continue;
+
+                    auto rendered = renderReference(settings, sampleRate, stimulus);
+                    double error = 0.0;
+
+                    for (size_t i = 0; i < rendered.size(); ++i)
+                        error = juce::jmax(error, std::abs(rendered[i] - (double) it->second[i]));
+
+                    expect(error <= referenceTolerance, key + ": the reference chain is " + juce::String(error) + " away from the stored render");
+                }
+            }
+        }
+    }
+
+    static void setParameter(SimpleEqAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    static void setParameters(SimpleEqAudioProcessor& processor, const GoldenSettings& settings, PeakMode peakMode)
+    {
+        setParameter(processor, "LowCut Freq", settings.lowCutFreq);
+        setParameter(processor, "HighCut Freq", settings.highCutFreq);
+        setParameter(processor, "LowCut Slope", (float) settings.slope);
+        setParameter(processor, "HighCut Slope", (float) settings.slope);
+
+        if (! settings.peaks)
+            return;
+
+        for (int peak = 0; peak < numGoldenPeaks; ++peak)
+        {
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Freq"), goldenPeaks[peak].freq);
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Gain"), goldenPeaks[peak].gainInDecibels);
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Quality"), goldenPeaks[peak].quality);
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Topology"), peakMode == stateVariablePeaks ? 1.f : 0.f);
+
+            //no stimulus comes near 0 dBFS in any band, so the dynamic bands stay at rest
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Dynamic"), peakMode == dynamicPeaks ? 1.f : 0.f);
+            setParameter(processor, ChainParameters::getPeakParameterID(peak, "Threshold"), 0.f);
+        }
+    }
+
+    template <typename FloatType>
+    static void prepare(SimpleEqAudioProcessor& processor, double sampleRate)
+    {
+        processor.setProcessingPrecision(std::is_same<FloatType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                 : juce::AudioProcessor::singlePrecision);
+        processor.setPlayConfigDetails(2, 2, sampleRate, goldenMaximumBlockSize);
+        processor.prepareToPlay(sampleRate, goldenMaximumBlockSize);
+    }
+
+    //runs the input through in the golden block sizes, with the inverted half level copy on the second channel.
+    //Returns the heap allocations the calling thread made in processBlock
+    template <typename FloatType>
+    static juce::int64 render(SimpleEqAudioProcessor& processor, const std::vector<float>& input, juce::AudioBuffer<double>& output)
+    {
+        auto length = (int) input.size();
+        juce::AudioBuffer<FloatType> block(2, goldenMaximumBlockSize);
+        juce::MidiBuffer midi;
+        juce::int64 allocations = 0;
+
+        output.setSize(2, length);
+
+        //a block of silence first. The processor suspends on it, and the reset that comes with that lands the state
+        //variable and dynamic bands prepareToPlay switched in, which would otherwise ramp in over the first samples
+        block.clear();
+
+        {
+            ScopedAllocationCounter counter;
+            processor.processBlock(block, midi);
+            allocations += counter.getCount();
+        }
+
+        for (int start = 0, blockIndex = 0; start < length; ++blockIndex)
+        {
+            auto numSamples = juce::jmin(goldenBlockSizes[blockIndex % (int) std::size(goldenBlockSizes)], length - start);
+            block.setSize(2, numSamples, false, false, true);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                block.setSample(0, i, (FloatType) input[(size_t) (start + i)]);
+                block.setSample(1, i, (FloatType) (-0.5f * input[(size_t) (start + i)]));
+            }
+
+            {
+                ScopedAllocationCounter counter;
+                processor.processBlock(block, midi);
+                allocations += counter.getCount();
+            }
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    output.setSample(channel, start + i, (double) block.getSample(channel, i));
+
+            start += numSamples;
+        }
+
+        return allocations;
+    }
+
+    template <typename FloatType>
+    void check(const juce::String& name, const GoldenSettings& settings, PeakMode peakMode, double sampleRate, int stimulus,
+               const std::vector<float>& expected)
+    {
+        SimpleEqAudioProcessor processor;
+
+        //nothing is designed behind the render's back, prepareToPlay designs every band up front
+        processor.setDesignOnCallingThread(true);
+        setParameters(processor, settings, peakMode);
+        prepare<FloatType>(processor, sampleRate);
+
+        juce::AudioBuffer<double> output;
+        auto allocations = render<FloatType>(processor, createStimulus(stimulus, sampleRate), output);
+        processor.releaseResources();
+
+        auto maximumError = std::is_same<FloatType, double>::value ? tolerance : floatTolerance;
+        double error = 0.0;
+        int firstBadSample = -1;
+
+        for (int i = 0; i < goldenLength; ++i)
+        {
+            auto reference = (double) expected[(size_t) i];
+            auto difference = juce::jmax(std::abs(output.getSample(0, i) - reference),
+                                         std::abs(output.getSample(1, i) + 0.5 * reference));
+
+            //NaN never compares greater, so it is caught explicitly
+            if (firstBadSample < 0 && (difference > maximumError || std::isnan(difference)))
+                firstBadSample = i;
+
+            error = juce::jmax(error, difference);
+        }
+
+        expect(firstBadSample < 0, name + ": max error " + juce::String(error) + ", first above the tolerance at sample " + juce::String(firstBadSample));
+        expect(allocations == 0, name + ": " + juce::String(allocations) + " heap allocations while processing");
+    }
+
+    template <typename FloatType>
+    void checkLinearPhase(const juce::String& name, const GoldenSettings& settings, double sampleRate)
+    {
+        SimpleEqAudioProcessor processor;
+
+        processor.setDesignOnCallingThread(true);
+        setParameters(processor, settings, biquadPeaks);
+        setParameter(processor, "Phase Mode", (float) LinearPhase);
+        setParameter(processor, "Linear Phase Quality", (float) linearPhaseQuality);
+        prepare<FloatType>(processor, sampleRate);
+
+        if (! processor.waitForLinearPhaseKernel(kernelTimeoutMs))
+        {
+            expect(false, name + ": the kernel was not loaded in time");
+            return;
+        }
+
+        auto kernelLength = LinearPhaseFilter::getKernelLength(linearPhaseQuality);
+        std::vector<float> impulse((size_t) (2 * kernelLength), 0.f);
+        impulse[0] = 1.f;
+
+        juce::AudioBuffer<double> output;
+        auto allocations = render<FloatType>(processor, impulse, output);
+        auto latency = processor.getLatencySamples();
+        processor.releaseResources();
+
+        if (latency < kernelLength / 2 || latency + kernelLength / 2 > (int) impulse.size())
+        {
+            expect(false, name + ": latency of " + juce::String(latency) + " samples for a kernel of " + juce::String(kernelLength));
+            return;
+        }
+
+        auto* response = output.getReadPointer(0);
+        double asymmetry = 0.0;
+
+        for (int i = 1; i < kernelLength / 2; ++i)
+            asymmetry = juce::jmax(asymmetry, std::abs(response[latency + i] - response[latency - i]));
+
+        ReferenceChain reference(settings, sampleRate);
+        double error = 0.0;
+
+        for (int point = 0; point < numMagnitudePoints; ++point)
+        {
+            auto freq = 100.0 * std::pow(15000.0 / 100.0, (double) point / (numMagnitudePoints - 1));
+            auto w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+            std::complex<double> sum;
+
+            for (int i = 0; i < output.getNumSamples(); ++i)
+                sum += response[i] * std::polar(1.0, -w * i);
+
+            auto magnitude = juce::Decibels::gainToDecibels(std::abs(sum), -200.0);
+            auto expected = juce::Decibels::gainToDecibels(reference.getMagnitudeForFrequency(freq, sampleRate), -200.0);
+            error = juce::jmax(error, std::abs(magnitude - expected));
+        }
+
+        expect(asymmetry <= symmetryTolerance, name + ": not symmetric about the reported latency, off by up to " + juce::String(asymmetry));
+        expect(error <= magnitudeToleranceDecibels, name + ": magnitude off by up to " + juce::String(error) + " dB");
+        expect(allocations == 0, name + ": " + juce::String(allocations) + " heap allocations while processing");
+    }
+
+    static constexpr double tolerance = 1.0e-5;
+    static constexpr double floatTolerance = 1.0e-3;
+
+    //the stored renders are the reference's rounded to float, re-rendering differs by less than that
+    static constexpr double referenceTolerance = 1.0e-6;
+
+    //the longest kernel, the shorter ones smear the 80 Hz peak by more than the tolerance at 96 kHz
+    static constexpr int linearPhaseQuality = 3;
+    static constexpr int kernelTimeoutMs = 10000;
+    static constexpr int numMagnitudePoints = 64;
+    static constexpr double magnitudeToleranceDecibels = 0.05;
+
+    //float convolution of a symmetric kernel, a response off by one sample is off by orders of magnitude more
+    static constexpr double symmetryTolerance = 1.0e-4;
+};
+
+static GoldenTests goldenTests;
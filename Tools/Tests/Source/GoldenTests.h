@@ -0,0 +1,17 @@
+/*
+  ==============================================================================
+
+    GoldenTests.h
+    Stored renders of the original plugin's processing, and the check of the
+    processor against them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//renders every golden case through the reference chain, the original MonoChain run in double, and
+//writes them in the format GoldenTests reads. Only needed when the cases or stimuli change
+bool writeGoldenRenders(const juce::File& file);
@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    Console test runner: runs every juce::UnitTest in the "SimpleEq" category
+    and exits with the number of failed tests, so a script or CI job can gate on
+    it.
+
+    SimpleEqTests
+    SimpleEqTests --write-golden golden.bin
+
+    The second form regenerates the golden renders from the reference chain
+    instead, to be reviewed and committed as Golden/golden.bin.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GoldenTests.h"
+
+int main(int argc, char* argv[])
+{
+    //the processor's apvts expects JUCE to be initialised, no message loop is ever run
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--write-golden"))
+        return writeGoldenRenders(args.getFileForOption("--write-golden")) ? 0 : 1;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("SimpleEq");
+
+    int failedTests = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        if (runner.getResult(i)->failures > 0)
+            ++failedTests;
+
+    return failedTests;
+}